@@ -1,8 +1,65 @@
 #include "include/RenderAPI/RenderAPI.h"
 
+#include <fstream>
+#include <iterator>
+
 namespace RenderAPI {
 bool IsDepthStencilFormat(TextureFormat format) {
   return (format >= TextureFormat::kD16_UNORM &&
           format <= TextureFormat::kD32_SFLOAT_S8_UINT);
 }
+
+bool operator==(const RenderPassCompatibility& lhs,
+                const RenderPassCompatibility& rhs) {
+  if (lhs.hash != rhs.hash ||
+      lhs.attachments.size() != rhs.attachments.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < lhs.attachments.size(); ++i) {
+    if (lhs.attachments[i].format != rhs.attachments[i].format ||
+        lhs.attachments[i].samples != rhs.attachments[i].samples) {
+      return false;
+    }
+  }
+  return true;
+}
+
+RenderPassCompatibility GetRenderPassCompatibility(
+    const RenderPassCreateInfo& info) {
+  RenderPassCompatibility compatibility;
+  compatibility.attachments.reserve(info.attachments.size());
+  uint64_t hash = info.attachments.size();
+  for (const auto& it : info.attachments) {
+    compatibility.attachments.push_back({it.format, it.samples});
+    const uint64_t value = (static_cast<uint64_t>(it.format) << 32) |
+                           static_cast<uint64_t>(it.samples);
+    hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+  }
+  compatibility.hash = hash;
+  return compatibility;
+}
+
+PipelineCache LoadPipelineCache(Device device, const char* filename,
+                                bool* discarded) {
+  std::ifstream file(filename, std::ios::binary);
+  if (!file.is_open()) {
+    if (discarded) {
+      *discarded = false;
+    }
+    return CreatePipelineCache(device);
+  }
+  std::vector<char> data((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+  return CreatePipelineCache(device, data.data(), data.size(), discarded);
+}
+
+bool SavePipelineCache(PipelineCache cache, const char* filename) {
+  std::vector<uint8_t> data = GetPipelineCacheData(cache);
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return false;
+  }
+  file.write(reinterpret_cast<const char*>(data.data()), data.size());
+  return file.good();
+}
 };  // namespace RenderAPI
\ No newline at end of file
@@ -0,0 +1,895 @@
+#include "RenderAPI_null.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include "generational/concurrent_generational_vector.h"
+
+namespace RenderAPI {
+namespace {
+constexpr uint32_t kSwapChainLength = 3;
+constexpr size_t kNumCalls = static_cast<size_t>(Null::Call::kCount);
+constexpr size_t kNumObjects = static_cast<size_t>(Null::Object::kCount);
+
+ConcurrentGenerationalVector<InstanceNull> instances_;
+ConcurrentGenerationalVector<DeviceNull> devices_;
+ConcurrentGenerationalVector<SwapChainNull> swapchains_;
+ConcurrentGenerationalVector<RenderPassNull> render_passes_;
+ConcurrentGenerationalVector<GraphicsPipelineNull> graphic_pipelines_;
+ConcurrentGenerationalVector<PipelineLayoutNull> pipeline_layouts_;
+ConcurrentGenerationalVector<FramebufferNull> framebuffers_;
+ConcurrentGenerationalVector<BufferNull> buffers_;
+ConcurrentGenerationalVector<CommandPoolNull> command_pools_;
+ConcurrentGenerationalVector<CommandBufferNull> command_buffers_;
+ConcurrentGenerationalVector<SemaphoreNull> semaphores_;
+ConcurrentGenerationalVector<FenceNull> fences_;
+ConcurrentGenerationalVector<DescriptorSetLayoutNull> descriptor_set_layouts_;
+ConcurrentGenerationalVector<DescriptorSetPoolNull> descriptor_set_pools_;
+ConcurrentGenerationalVector<DescriptorSetNull> descriptor_sets_;
+ConcurrentGenerationalVector<ImageNull> images_;
+ConcurrentGenerationalVector<ImageViewNull> image_views_;
+ConcurrentGenerationalVector<SamplerNull> samplers_;
+ConcurrentGenerationalVector<ShaderModuleNull> shader_modules_;
+ConcurrentGenerationalVector<UploadQueueNull> upload_queues_;
+ConcurrentGenerationalVector<PipelineCacheNull> pipeline_caches_;
+ConcurrentGenerationalVector<MemoryHeapNull> memory_heaps_;
+
+// Counters are updated from any thread.
+struct AtomicObjectCounters {
+  std::atomic<uint64_t> created{0};
+  std::atomic<uint64_t> destroyed{0};
+};
+std::atomic<uint64_t> call_counts_[kNumCalls] = {};
+AtomicObjectCounters object_counters_[kNumObjects];
+
+void Count(Null::Call call) {
+  call_counts_[static_cast<size_t>(call)].fetch_add(1,
+                                                    std::memory_order_relaxed);
+}
+
+// Close enough for the formats render targets use, so memory reports match a
+// real device.
+uint64_t GetTexelSize(TextureFormat format) {
+  switch (format) {
+    case TextureFormat::kR8_UNORM:
+      return 1;
+    case TextureFormat::kD16_UNORM:
+      return 2;
+    case TextureFormat::kR16G16B16A16_SFLOAT:
+    case TextureFormat::kD32_SFLOAT_S8_UINT:
+      return 8;
+    case TextureFormat::kR32G32B32A32_SFLOAT:
+      return 16;
+    default:
+      return 4;
+  }
+}
+
+constexpr uint64_t kImageAlignment = 65536;
+constexpr uint32_t kMemoryTypeBits = 1;
+
+uint64_t GetImageSize(const ImageCreateInfo& info) {
+  uint64_t size = 0;
+  for (uint32_t mip = 0; mip < info.mips; ++mip) {
+    const uint64_t width = std::max(info.extent.width >> mip, 1u);
+    const uint64_t height = std::max(info.extent.height >> mip, 1u);
+    const uint64_t depth = std::max(info.extent.depth >> mip, 1u);
+    size += width * height * depth;
+  }
+  size *= info.array_layers * GetTexelSize(info.format);
+  return (size + kImageAlignment - 1) / kImageAlignment * kImageAlignment;
+}
+
+template <typename T>
+HandleType Track(Null::Object object, ConcurrentGenerationalVector<T>& objects,
+                 T&& data) {
+  object_counters_[static_cast<size_t>(object)].created.fetch_add(
+      1, std::memory_order_relaxed);
+  return objects.Create(std::move(data));
+}
+
+template <typename T>
+void Untrack(Null::Object object, ConcurrentGenerationalVector<T>& objects,
+             HandleType handle) {
+  objects.Destroy(handle);
+  object_counters_[static_cast<size_t>(object)].destroyed.fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+CommandBufferNull& RecordingCommandBuffer(CommandBuffer buffer) {
+  CommandBufferNull& cmd = command_buffers_[buffer];
+  assert(cmd.recording && "Command buffer is not recording!");
+  return cmd;
+}
+
+CommandBufferNull& RenderPassCommandBuffer(CommandBuffer buffer) {
+  CommandBufferNull& cmd = RecordingCommandBuffer(buffer);
+  assert(cmd.in_render_pass && "Command must be recorded in a render pass!");
+  assert(!cmd.secondary_contents &&
+         "Render pass only accepts secondary command buffers!");
+  return cmd;
+}
+}  // namespace
+
+Instance Create(const char* const* extensions, uint32_t extensions_count) {
+  Count(Null::Call::kCreate);
+  return Track(Null::Object::kInstance, instances_, InstanceNull());
+}
+
+void Destroy(Instance instance) {
+  Count(Null::Call::kDestroy);
+  Untrack(Null::Object::kInstance, instances_, instance);
+}
+
+Device CreateDevice(Instance instance) {
+  Count(Null::Call::kCreateDevice);
+  DeviceNull device;
+  device.instance = instance;
+  return Track(Null::Object::kDevice, devices_, std::move(device));
+}
+
+void DestroyDevice(Device device) {
+  Count(Null::Call::kDestroyDevice);
+  Untrack(Null::Object::kDevice, devices_, device);
+}
+
+void DeviceWaitIdle(Device device) { Count(Null::Call::kDeviceWaitIdle); }
+
+SwapChain CreateSwapChain(Device device, uint32_t width, uint32_t height) {
+  Count(Null::Call::kCreateSwapChain);
+  SwapChainNull swapchain;
+  swapchain.device = device;
+  swapchain.format = TextureFormat::kB8G8R8A8_UNORM;
+  swapchain.extent = Extent2D(width, height);
+  for (uint32_t i = 0; i < kSwapChainLength; ++i) {
+    ImageViewNull view;
+    view.device = device;
+    view.image = kInvalidHandle;
+    swapchain.image_views.push_back(
+        Track(Null::Object::kImageView, image_views_, std::move(view)));
+  }
+  return Track(Null::Object::kSwapChain, swapchains_, std::move(swapchain));
+}
+
+void DestroySwapChain(SwapChain swapchain) {
+  Count(Null::Call::kDestroySwapChain);
+  for (auto& view : swapchains_[swapchain].image_views) {
+    Untrack(Null::Object::kImageView, image_views_, view);
+  }
+  Untrack(Null::Object::kSwapChain, swapchains_, swapchain);
+}
+
+uint32_t GetSwapChainLength(SwapChain swapchain) {
+  Count(Null::Call::kGetSwapChainLength);
+  return static_cast<uint32_t>(swapchains_[swapchain].image_views.size());
+}
+
+void AcquireNextImage(SwapChain swapchain, uint64_t timeout_ns,
+                      Semaphore semaphore, uint32_t* out_image_index) {
+  Count(Null::Call::kAcquireNextImage);
+  SwapChainNull& swapchain_null = swapchains_[swapchain];
+  *out_image_index = swapchain_null.next_image;
+  swapchain_null.next_image =
+      (swapchain_null.next_image + 1) % swapchain_null.image_views.size();
+}
+
+TextureFormat GetSwapChainImageFormat(SwapChain swapchain) {
+  Count(Null::Call::kGetSwapChainImageFormat);
+  return swapchains_[swapchain].format;
+}
+
+ImageView GetSwapChainImageView(SwapChain swapchain, uint32_t index) {
+  Count(Null::Call::kGetSwapChainImageView);
+  return swapchains_[swapchain].image_views[index];
+}
+
+PipelineLayout CreatePipelineLayout(Device device,
+                                    const PipelineLayoutCreateInfo& info) {
+  Count(Null::Call::kCreatePipelineLayout);
+  PipelineLayoutNull layout;
+  layout.device = device;
+  layout.info = info;
+  return Track(Null::Object::kPipelineLayout, pipeline_layouts_,
+               std::move(layout));
+}
+
+void DestroyPipelineLayout(Device device, PipelineLayout layout) {
+  Count(Null::Call::kDestroyPipelineLayout);
+  Untrack(Null::Object::kPipelineLayout, pipeline_layouts_, layout);
+}
+
+GraphicsPipeline CreateGraphicsPipeline(Device device, RenderPass pass,
+                                        const GraphicsPipelineCreateInfo& info,
+                                        PipelineCache cache) {
+  Count(Null::Call::kCreateGraphicsPipeline);
+  if (cache != kInvalidHandle) {
+    pipeline_caches_[cache];
+  }
+  GraphicsPipelineNull pipeline;
+  pipeline.device = device;
+  pipeline.pass = pass;
+  pipeline.layout = info.layout;
+  return Track(Null::Object::kGraphicsPipeline, graphic_pipelines_,
+               std::move(pipeline));
+}
+
+void DestroyGraphicsPipeline(GraphicsPipeline pipeline) {
+  Count(Null::Call::kDestroyGraphicsPipeline);
+  Untrack(Null::Object::kGraphicsPipeline, graphic_pipelines_, pipeline);
+}
+
+PipelineCache CreatePipelineCache(Device device, const void* data,
+                                  size_t size, bool* discarded) {
+  Count(Null::Call::kCreatePipelineCache);
+  if (discarded) {
+    *discarded = false;
+  }
+  PipelineCacheNull cache;
+  cache.device = device;
+  if (data) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    cache.data.assign(bytes, bytes + size);
+  }
+  return Track(Null::Object::kPipelineCache, pipeline_caches_,
+               std::move(cache));
+}
+
+void DestroyPipelineCache(PipelineCache cache) {
+  Count(Null::Call::kDestroyPipelineCache);
+  Untrack(Null::Object::kPipelineCache, pipeline_caches_, cache);
+}
+
+std::vector<uint8_t> GetPipelineCacheData(PipelineCache cache) {
+  Count(Null::Call::kGetPipelineCacheData);
+  return pipeline_caches_[cache].data;
+}
+
+RenderPass CreateRenderPass(Device device, const RenderPassCreateInfo& info) {
+  Count(Null::Call::kCreateRenderPass);
+  RenderPassNull pass;
+  pass.device = device;
+  pass.info = info;
+  return Track(Null::Object::kRenderPass, render_passes_, std::move(pass));
+}
+
+void DestroyRenderPass(RenderPass pass) {
+  Count(Null::Call::kDestroyRenderPass);
+  Untrack(Null::Object::kRenderPass, render_passes_, pass);
+}
+
+RenderPassCompatibility GetRenderPassCompatibility(RenderPass pass) {
+  Count(Null::Call::kGetRenderPassCompatibility);
+  return GetRenderPassCompatibility(render_passes_[pass].info);
+}
+
+Framebuffer CreateFramebuffer(Device device,
+                              const FramebufferCreateInfo& info) {
+  Count(Null::Call::kCreateFramebuffer);
+  FramebufferNull framebuffer;
+  framebuffer.device = device;
+  framebuffer.info = info;
+  return Track(Null::Object::kFramebuffer, framebuffers_,
+               std::move(framebuffer));
+}
+
+void DestroyFramebuffer(Framebuffer buffer) {
+  Count(Null::Call::kDestroyFramebuffer);
+  Untrack(Null::Object::kFramebuffer, framebuffers_, buffer);
+}
+
+Buffer CreateBuffer(Device device, BufferUsageFlags usage, uint64_t size,
+                    MemoryUsage memory_usage) {
+  Count(Null::Call::kCreateBuffer);
+  BufferNull buffer;
+  buffer.device = device;
+  buffer.usage = usage;
+  buffer.memory_usage = memory_usage;
+  buffer.data.resize(size);
+  return Track(Null::Object::kBuffer, buffers_, std::move(buffer));
+}
+
+void DestroyBuffer(Buffer buffer) {
+  Count(Null::Call::kDestroyBuffer);
+  BufferNull& buffer_null = buffers_[buffer];
+  assert(!buffer_null.mapped && "Destroying a mapped buffer!");
+  std::vector<uint8_t>().swap(buffer_null.data);
+  Untrack(Null::Object::kBuffer, buffers_, buffer);
+}
+
+void* MapBuffer(Buffer buffer) {
+  Count(Null::Call::kMapBuffer);
+  BufferNull& buffer_null = buffers_[buffer];
+  assert(!buffer_null.mapped && "Buffer already mapped!");
+  buffer_null.mapped = true;
+  return buffer_null.data.data();
+}
+
+void UnmapBuffer(Buffer buffer) {
+  Count(Null::Call::kUnmapBuffer);
+  BufferNull& buffer_null = buffers_[buffer];
+  assert(buffer_null.mapped && "Buffer is not mapped!");
+  buffer_null.mapped = false;
+}
+
+CommandPool CreateCommandPool(Device device, CommandPoolCreateFlags flags) {
+  Count(Null::Call::kCreateCommandPool);
+  CommandPoolNull pool;
+  pool.device = device;
+  pool.flags = flags;
+  return Track(Null::Object::kCommandPool, command_pools_, std::move(pool));
+}
+
+void DestroyCommandPool(CommandPool pool) {
+  Count(Null::Call::kDestroyCommandPool);
+  Untrack(Null::Object::kCommandPool, command_pools_, pool);
+}
+
+CommandBuffer CreateCommandBuffer(CommandPool pool, CommandBufferLevel level) {
+  Count(Null::Call::kCreateCommandBuffer);
+  CommandBufferNull buffer;
+  buffer.device = command_pools_[pool].device;
+  buffer.pool = pool;
+  buffer.level = level;
+  return Track(Null::Object::kCommandBuffer, command_buffers_,
+               std::move(buffer));
+}
+
+void DestroyCommandBuffer(CommandBuffer buffer) {
+  Count(Null::Call::kDestroyCommandBuffer);
+  Untrack(Null::Object::kCommandBuffer, command_buffers_, buffer);
+}
+
+void CmdBegin(CommandBuffer buffer) {
+  Count(Null::Call::kCmdBegin);
+  CommandBufferNull& cmd = command_buffers_[buffer];
+  assert(!cmd.recording && "Command buffer already recording!");
+  cmd.recording = true;
+  cmd.in_render_pass = false;
+  cmd.continues_render_pass = false;
+  cmd.secondary_contents = false;
+}
+
+void CmdBegin(CommandBuffer buffer,
+              const CommandBufferInheritanceInfo& inheritance) {
+  Count(Null::Call::kCmdBegin);
+  CommandBufferNull& cmd = command_buffers_[buffer];
+  assert(!cmd.recording && "Command buffer already recording!");
+  assert(cmd.level == CommandBufferLevel::kSecondary &&
+         "Only secondary command buffers inherit a render pass!");
+  render_passes_[inheritance.pass];
+  if (inheritance.framebuffer != kInvalidHandle) {
+    framebuffers_[inheritance.framebuffer];
+  }
+  cmd.recording = true;
+  cmd.in_render_pass = true;
+  cmd.continues_render_pass = true;
+  cmd.secondary_contents = false;
+}
+
+void CmdEnd(CommandBuffer buffer) {
+  Count(Null::Call::kCmdEnd);
+  CommandBufferNull& cmd = RecordingCommandBuffer(buffer);
+  assert((!cmd.in_render_pass || cmd.continues_render_pass) &&
+         "Render pass was not ended!");
+  cmd.recording = false;
+}
+
+void CmdSetViewport(CommandBuffer buffer, uint32_t first_viewport,
+                    uint32_t viewport_count, const Viewport* viewports) {
+  Count(Null::Call::kCmdSetViewport);
+  RecordingCommandBuffer(buffer);
+}
+
+void CmdSetScissor(CommandBuffer buffer, uint32_t first_scissor, uint32_t count,
+                   const Rect2D* scissors) {
+  Count(Null::Call::kCmdSetScissor);
+  RecordingCommandBuffer(buffer);
+}
+
+void CmdBeginRenderPass(CommandBuffer buffer, const BeginRenderPassInfo& info) {
+  Count(Null::Call::kCmdBeginRenderPass);
+  CommandBufferNull& cmd = RecordingCommandBuffer(buffer);
+  assert(!cmd.in_render_pass && "Render pass already begun!");
+  // Validate the handles.
+  render_passes_[info.pass];
+  framebuffers_[info.framebuffer];
+  cmd.in_render_pass = true;
+  cmd.secondary_contents =
+      info.contents == SubpassContents::kSecondaryCommandBuffers;
+}
+
+void CmdEndRenderPass(CommandBuffer buffer) {
+  Count(Null::Call::kCmdEndRenderPass);
+  CommandBufferNull& cmd = RecordingCommandBuffer(buffer);
+  assert(cmd.in_render_pass && !cmd.continues_render_pass &&
+         "Ending a render pass that wasn't begun!");
+  cmd.in_render_pass = false;
+  cmd.secondary_contents = false;
+}
+
+void CmdBindPipeline(CommandBuffer buffer, GraphicsPipeline pipeline) {
+  Count(Null::Call::kCmdBindPipeline);
+  RecordingCommandBuffer(buffer);
+  graphic_pipelines_[pipeline];
+}
+
+void CmdBindVertexBuffers(CommandBuffer buffer, uint32_t first_binding,
+                          uint32_t binding_count, const Buffer* buffers,
+                          const uint64_t* offsets) {
+  Count(Null::Call::kCmdBindVertexBuffers);
+  RecordingCommandBuffer(buffer);
+  for (uint32_t i = 0; i < binding_count; ++i) {
+    buffers_[buffers[i]];
+  }
+}
+
+void CmdBindDescriptorSets(CommandBuffer cmd, int type, PipelineLayout layout,
+                           uint32_t first, uint32_t count,
+                           const DescriptorSet* sets,
+                           uint32_t dynamic_sets_count,
+                           const uint32_t* dynamic_sets_offsets) {
+  Count(Null::Call::kCmdBindDescriptorSets);
+  RecordingCommandBuffer(cmd);
+  assert(first + count <= pipeline_layouts_[layout].info.layouts.size() &&
+         "Binding more sets than the pipeline layout has!");
+  for (uint32_t i = 0; i < count; ++i) {
+    descriptor_sets_[sets[i]];
+  }
+}
+
+void CmdPushConstants(CommandBuffer cmd, PipelineLayout layout,
+                      ShaderStageFlags flags, uint32_t offset, uint32_t size,
+                      const void* values) {
+  Count(Null::Call::kCmdPushConstants);
+  RecordingCommandBuffer(cmd);
+  pipeline_layouts_[layout];
+}
+
+void CmdBindIndexBuffer(CommandBuffer cmd, Buffer buffer, IndexType type,
+                        uint64_t offset) {
+  Count(Null::Call::kCmdBindIndexBuffer);
+  RecordingCommandBuffer(cmd);
+  buffers_[buffer];
+}
+
+void CmdDraw(CommandBuffer buffer, uint32_t vertex_count,
+             uint32_t instance_count, uint32_t first_vertex,
+             uint32_t first_instance) {
+  Count(Null::Call::kCmdDraw);
+  RenderPassCommandBuffer(buffer);
+}
+
+void CmdDrawIndexed(CommandBuffer cmd, uint32_t index_count,
+                    uint32_t instance_count, uint32_t first_index,
+                    int32_t vertex_offset, uint32_t first_instance) {
+  Count(Null::Call::kCmdDrawIndexed);
+  RenderPassCommandBuffer(cmd);
+}
+
+void CmdCopyBuffer(CommandBuffer cmd, Buffer src, Buffer dst,
+                   uint32_t region_count, const BufferCopy* regions) {
+  Count(Null::Call::kCmdCopyBuffer);
+  CommandBufferNull& cmd_null = RecordingCommandBuffer(cmd);
+  assert(!cmd_null.in_render_pass && "Copies are not allowed in render pass!");
+  const BufferNull& src_buffer = buffers_[src];
+  BufferNull& dst_buffer = buffers_[dst];
+  for (uint32_t i = 0; i < region_count; ++i) {
+    assert(regions[i].src_offset + regions[i].size <= src_buffer.data.size());
+    assert(regions[i].dst_offset + regions[i].size <= dst_buffer.data.size());
+  }
+}
+
+void CmdPipelineBarrier(CommandBuffer cmd, const PipelineBarrier& barrier) {
+  Count(Null::Call::kCmdPipelineBarrier);
+  CommandBufferNull& cmd_null = RecordingCommandBuffer(cmd);
+  assert(!cmd_null.in_render_pass && "Barriers are not allowed in a pass!");
+  assert(barrier.src_stages && barrier.dst_stages && "Empty stage masks!");
+}
+
+void CmdExecuteCommands(CommandBuffer buffer, uint32_t count,
+                        const CommandBuffer* buffers) {
+  Count(Null::Call::kCmdExecuteCommands);
+  CommandBufferNull& cmd = RecordingCommandBuffer(buffer);
+  assert(cmd.level == CommandBufferLevel::kPrimary &&
+         "Secondary command buffers can't execute commands!");
+  assert((!cmd.in_render_pass || cmd.secondary_contents) &&
+         "Render pass doesn't accept secondary command buffers!");
+  for (uint32_t i = 0; i < count; ++i) {
+    const CommandBufferNull& secondary = command_buffers_[buffers[i]];
+    assert(secondary.level == CommandBufferLevel::kSecondary &&
+           !secondary.recording && "Executing an unfinished command buffer!");
+    assert(secondary.continues_render_pass == cmd.in_render_pass &&
+           "Secondary command buffer doesn't match the render pass!");
+  }
+}
+
+Semaphore CreateSemaphore(Device device) {
+  Count(Null::Call::kCreateSemaphore);
+  SemaphoreNull semaphore;
+  semaphore.device = device;
+  return Track(Null::Object::kSemaphore, semaphores_, std::move(semaphore));
+}
+
+void DestroySemaphore(Semaphore semaphore) {
+  Count(Null::Call::kDestroySemaphore);
+  Untrack(Null::Object::kSemaphore, semaphores_, semaphore);
+}
+
+Fence CreateFence(Device device, bool signaled) {
+  Count(Null::Call::kCreateFence);
+  FenceNull fence;
+  fence.device = device;
+  fence.signaled = signaled;
+  return Track(Null::Object::kFence, fences_, std::move(fence));
+}
+
+void DestroyFence(Fence fence) {
+  Count(Null::Call::kDestroyFence);
+  Untrack(Null::Object::kFence, fences_, fence);
+}
+
+void WaitForFences(const Fence* fences, uint32_t count, bool wait_for_all,
+                   uint64_t timeout_ns) {
+  Count(Null::Call::kWaitForFences);
+  for (uint32_t i = 0; i < count; ++i) {
+    fences_[fences[i]];
+  }
+}
+
+void ResetFences(const Fence* fences, uint32_t count) {
+  Count(Null::Call::kResetFences);
+  for (uint32_t i = 0; i < count; ++i) {
+    fences_[fences[i]].signaled = false;
+  }
+}
+
+DescriptorSetLayout CreateDescriptorSetLayout(
+    Device device, const DescriptorSetLayoutCreateInfo& info) {
+  Count(Null::Call::kCreateDescriptorSetLayout);
+  DescriptorSetLayoutNull layout;
+  layout.device = device;
+  layout.info = info;
+  return Track(Null::Object::kDescriptorSetLayout, descriptor_set_layouts_,
+               std::move(layout));
+}
+
+void DestroyDescriptorSetLayout(DescriptorSetLayout layout) {
+  Count(Null::Call::kDestroyDescriptorSetLayout);
+  Untrack(Null::Object::kDescriptorSetLayout, descriptor_set_layouts_, layout);
+}
+
+DescriptorSetPool CreateDescriptorSetPool(
+    Device device, const CreateDescriptorSetPoolCreateInfo& info) {
+  Count(Null::Call::kCreateDescriptorSetPool);
+  DescriptorSetPoolNull pool;
+  pool.device = device;
+  pool.max_sets = info.max_sets;
+  return Track(Null::Object::kDescriptorSetPool, descriptor_set_pools_,
+               std::move(pool));
+}
+
+void DestroyDescriptorSetPool(DescriptorSetPool pool) {
+  Count(Null::Call::kDestroyDescriptorSetPool);
+  // Sets are freed together with their pool.
+  for (auto& set : descriptor_set_pools_[pool].sets) {
+    Untrack(Null::Object::kDescriptorSet, descriptor_sets_, set);
+  }
+  Untrack(Null::Object::kDescriptorSetPool, descriptor_set_pools_, pool);
+}
+
+void AllocateDescriptorSets(DescriptorSetPool pool,
+                            const std::vector<DescriptorSetLayout>& layouts,
+                            DescriptorSet* sets) {
+  Count(Null::Call::kAllocateDescriptorSets);
+  DescriptorSetPoolNull& pool_null = descriptor_set_pools_[pool];
+  if (pool_null.sets.size() + layouts.size() > pool_null.max_sets) {
+    throw std::runtime_error("failed to allocate descriptor sets!");
+  }
+  for (size_t i = 0; i < layouts.size(); ++i) {
+    DescriptorSetNull set;
+    set.pool = pool;
+    set.layout = layouts[i];
+    sets[i] =
+        Track(Null::Object::kDescriptorSet, descriptor_sets_, std::move(set));
+    pool_null.sets.push_back(sets[i]);
+  }
+}
+
+void UpdateDescriptorSets(Device device, uint32_t descriptor_write_count,
+                          WriteDescriptorSet* descriptor_writes,
+                          uint32_t descriptor_copy_count,
+                          CopyDescriptorSet* descriptor_copies) {
+  Count(Null::Call::kUpdateDescriptorSets);
+  for (uint32_t i = 0; i < descriptor_write_count; ++i) {
+    descriptor_sets_[descriptor_writes[i].set];
+  }
+  for (uint32_t i = 0; i < descriptor_copy_count; ++i) {
+    descriptor_sets_[descriptor_copies[i].src_set];
+    descriptor_sets_[descriptor_copies[i].dst_set];
+  }
+}
+
+void QueueSubmit(Device device, const SubmitInfo& info, Fence fence) {
+  QueueSubmit(device, &info, 1, fence);
+}
+
+void QueueSubmit(Device device, const SubmitInfo* infos, uint32_t count,
+                 Fence fence) {
+  Count(Null::Call::kQueueSubmit);
+  for (uint32_t submit = 0; submit < count; ++submit) {
+    const SubmitInfo& info = infos[submit];
+    for (uint32_t i = 0; i < info.wait_semaphores_count; ++i) {
+      semaphores_[info.wait_semaphores[i]];
+      assert((!info.wait_stages || info.wait_stages[i]) &&
+             "Empty wait stage mask!");
+    }
+    for (uint32_t i = 0; i < info.signal_semaphores_count; ++i) {
+      semaphores_[info.signal_semaphores[i]];
+    }
+    for (uint32_t i = 0; i < info.command_buffers_count; ++i) {
+      assert(!command_buffers_[info.command_buffers[i]].recording &&
+             "Submitting a command buffer that is still recording!");
+    }
+  }
+  // Work completes immediately.
+  if (fence != kInvalidHandle) {
+    fences_[fence].signaled = true;
+  }
+}
+
+void QueuePresent(SwapChain swapchain, uint32_t image,
+                  const PresentInfo& info) {
+  Count(Null::Call::kQueuePresent);
+  assert(image < swapchains_[swapchain].image_views.size());
+}
+
+Image CreateImage(Device device, const ImageCreateInfo& info) {
+  Count(Null::Call::kCreateImage);
+  ImageNull image;
+  image.device = device;
+  image.info = info;
+  return Track(Null::Object::kImage, images_, std::move(image));
+}
+
+void DestroyImage(Image image) {
+  Count(Null::Call::kDestroyImage);
+  Untrack(Null::Object::kImage, images_, image);
+}
+
+MemoryRequirements GetImageMemoryRequirements(Device device,
+                                              const ImageCreateInfo& info) {
+  Count(Null::Call::kGetImageMemoryRequirements);
+  devices_[device];
+  MemoryRequirements requirements;
+  requirements.alignment = kImageAlignment;
+  requirements.size = GetImageSize(info);
+  requirements.memory_type_bits = kMemoryTypeBits;
+  return requirements;
+}
+
+MemoryHeap CreateMemoryHeap(Device device, uint64_t size,
+                            uint32_t memory_type_bits) {
+  Count(Null::Call::kCreateMemoryHeap);
+  assert((memory_type_bits & kMemoryTypeBits) && "Unsupported memory type!");
+  MemoryHeapNull heap;
+  heap.device = device;
+  heap.size = size;
+  heap.memory_type_bits = memory_type_bits;
+  return Track(Null::Object::kMemoryHeap, memory_heaps_, std::move(heap));
+}
+
+void DestroyMemoryHeap(MemoryHeap heap) {
+  Count(Null::Call::kDestroyMemoryHeap);
+  Untrack(Null::Object::kMemoryHeap, memory_heaps_, heap);
+}
+
+Image CreateAliasedImage(Device device, const ImageCreateInfo& info,
+                         MemoryHeap heap, uint64_t offset) {
+  Count(Null::Call::kCreateAliasedImage);
+  assert(offset % kImageAlignment == 0 && "Misaligned image offset!");
+  assert(offset + GetImageSize(info) <= memory_heaps_[heap].size &&
+         "Image exceeds the heap!");
+  ImageNull image;
+  image.device = device;
+  image.info = info;
+  image.heap = heap;
+  image.offset = offset;
+  return Track(Null::Object::kImage, images_, std::move(image));
+}
+
+ShaderModule CreateShaderModule(Device device, const uint32_t* code,
+                                size_t size) {
+  Count(Null::Call::kCreateShaderModule);
+  ShaderModuleNull module;
+  module.device = device;
+  module.size = size;
+  return Track(Null::Object::kShaderModule, shader_modules_,
+               std::move(module));
+}
+
+void DestroyShaderModule(Device device, ShaderModule module) {
+  Count(Null::Call::kDestroyShaderModule);
+  Untrack(Null::Object::kShaderModule, shader_modules_, module);
+}
+
+void StageCopyDataToBuffer(CommandPool pool, Buffer buffer, const void* data,
+                           uint64_t size) {
+  Count(Null::Call::kStageCopyDataToBuffer);
+  command_pools_[pool];
+  BufferNull& buffer_null = buffers_[buffer];
+  assert(size <= buffer_null.data.size() && "Copy is larger than buffer!");
+  std::memcpy(buffer_null.data.data(), data, size);
+}
+
+void StageCopyDataToImage(CommandPool pool, Image image, const void* data,
+                          uint64_t size, uint32_t num_regions,
+                          const BufferImageCopy* regions) {
+  Count(Null::Call::kStageCopyDataToImage);
+  command_pools_[pool];
+  images_[image];
+}
+
+ImageView CreateImageView(Device device, const ImageViewCreateInfo& info) {
+  Count(Null::Call::kCreateImageView);
+  ImageViewNull view;
+  view.device = device;
+  view.image = info.image;
+  return Track(Null::Object::kImageView, image_views_, std::move(view));
+}
+
+void DestroyImageView(Device device, ImageView view) {
+  Count(Null::Call::kDestroyImageView);
+  Untrack(Null::Object::kImageView, image_views_, view);
+}
+
+Sampler CreateSampler(Device device, SamplerCreateInfo info) {
+  Count(Null::Call::kCreateSampler);
+  SamplerNull sampler;
+  sampler.device = device;
+  sampler.info = std::move(info);
+  return Track(Null::Object::kSampler, samplers_, std::move(sampler));
+}
+
+void DestroySampler(Device device, Sampler sampler) {
+  Count(Null::Call::kDestroySampler);
+  Untrack(Null::Object::kSampler, samplers_, sampler);
+}
+
+UploadQueue CreateUploadQueue(Device device, uint64_t staging_size) {
+  Count(Null::Call::kCreateUploadQueue);
+  UploadQueueNull queue;
+  queue.device = device;
+  return Track(Null::Object::kUploadQueue, upload_queues_, std::move(queue));
+}
+
+void DestroyUploadQueue(UploadQueue queue) {
+  Count(Null::Call::kDestroyUploadQueue);
+  Untrack(Null::Object::kUploadQueue, upload_queues_, queue);
+}
+
+UploadToken UploadToBuffer(UploadQueue queue, Buffer buffer, const void* data,
+                           uint64_t size, uint64_t offset) {
+  Count(Null::Call::kUploadToBuffer);
+  UploadQueueNull& queue_null = upload_queues_[queue];
+  BufferNull& buffer_null = buffers_[buffer];
+  assert(offset + size <= buffer_null.data.size() &&
+         "Upload is larger than buffer!");
+  std::memcpy(buffer_null.data.data() + offset, data, size);
+  queue_null.pending = true;
+  return queue_null.next_token;
+}
+
+UploadToken UploadToImage(UploadQueue queue, Image image, const void* data,
+                          uint64_t size, uint32_t num_regions,
+                          const BufferImageCopy* regions) {
+  Count(Null::Call::kUploadToImage);
+  UploadQueueNull& queue_null = upload_queues_[queue];
+  images_[image];
+  queue_null.pending = true;
+  return queue_null.next_token;
+}
+
+UploadToken FlushUploads(UploadQueue queue) {
+  Count(Null::Call::kFlushUploads);
+  UploadQueueNull& queue_null = upload_queues_[queue];
+  if (queue_null.pending) {
+    queue_null.completed = queue_null.next_token++;
+    queue_null.pending = false;
+  }
+  return queue_null.next_token - 1;
+}
+
+bool IsUploadComplete(UploadQueue queue, UploadToken token) {
+  Count(Null::Call::kIsUploadComplete);
+  return upload_queues_[queue].completed >= token;
+}
+
+void WaitForUpload(UploadQueue queue, UploadToken token) {
+  Count(Null::Call::kWaitForUpload);
+  UploadQueueNull& queue_null = upload_queues_[queue];
+  if (queue_null.pending && token >= queue_null.next_token) {
+    queue_null.completed = queue_null.next_token++;
+    queue_null.pending = false;
+  }
+}
+
+namespace Null {
+uint64_t GetCallCount(Call call) {
+  return call_counts_[static_cast<size_t>(call)].load(
+      std::memory_order_relaxed);
+}
+
+const char* GetCallName(Call call) {
+#define RENDER_API_NULL_CALL_NAME(name) #name,
+  static const char* kNames[] = {
+      RENDER_API_NULL_CALLS(RENDER_API_NULL_CALL_NAME)};
+#undef RENDER_API_NULL_CALL_NAME
+  return kNames[static_cast<size_t>(call)];
+}
+
+void ResetCallCounts() {
+  for (auto& count : call_counts_) {
+    count = 0;
+  }
+}
+
+ObjectCounters GetObjectCounters(Object object) {
+  const AtomicObjectCounters& atomic_counters =
+      object_counters_[static_cast<size_t>(object)];
+  ObjectCounters counters;
+  counters.created = atomic_counters.created.load(std::memory_order_relaxed);
+  counters.destroyed =
+      atomic_counters.destroyed.load(std::memory_order_relaxed);
+  return counters;
+}
+
+const char* GetObjectName(Object object) {
+  static const char* kNames[] = {
+      "Instance",
+      "Device",
+      "SwapChain",
+      "RenderPass",
+      "GraphicsPipeline",
+      "PipelineLayout",
+      "Framebuffer",
+      "Buffer",
+      "CommandPool",
+      "CommandBuffer",
+      "Semaphore",
+      "Fence",
+      "DescriptorSetLayout",
+      "DescriptorSetPool",
+      "DescriptorSet",
+      "Image",
+      "ImageView",
+      "Sampler",
+      "ShaderModule",
+      "UploadQueue",
+      "PipelineCache",
+      "MemoryHeap"};
+  static_assert(sizeof(kNames) / sizeof(kNames[0]) == kNumObjects,
+                "Missing object names!");
+  return kNames[static_cast<size_t>(object)];
+}
+
+uint64_t ReportLeaks() {
+  uint64_t leaks = 0;
+  for (size_t i = 0; i < kNumObjects; ++i) {
+    const ObjectCounters counters = GetObjectCounters(static_cast<Object>(i));
+    if (counters.Alive() > 0) {
+      std::cout << "RenderAPI::Null: " << counters.Alive() << " "
+                << GetObjectName(static_cast<Object>(i))
+                << " object(s) alive (created " << counters.created
+                << ", destroyed " << counters.destroyed << ")." << std::endl;
+      leaks += counters.Alive();
+    }
+  }
+  return leaks;
+}
+}  // namespace Null
+
+}  // namespace RenderAPI
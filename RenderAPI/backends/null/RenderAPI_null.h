@@ -0,0 +1,285 @@
+#pragma once
+
+#include <RenderAPI/RenderAPI.h>
+#include <cstdint>
+#include <vector>
+
+// Headless backend. Implements the full RenderAPI with the same handle
+// semantics and threading contract as the Vulkan backend, but never touches a
+// GPU: commands are validated and counted, submits complete immediately and
+// buffers are backed by host memory.
+
+// Remove windows defined CreateSemaphore macro.
+#ifdef CreateSemaphore
+#undef CreateSemaphore
+#endif
+
+namespace RenderAPI {
+
+struct InstanceNull {};
+
+struct DeviceNull {
+  Instance instance;
+};
+
+struct SwapChainNull {
+  Device device;
+  std::vector<ImageView> image_views;
+  TextureFormat format;
+  Extent2D extent;
+  uint32_t next_image = 0;
+};
+
+struct RenderPassNull {
+  Device device;
+  RenderPassCreateInfo info;
+};
+
+struct GraphicsPipelineNull {
+  Device device;
+  RenderPass pass;
+  PipelineLayout layout;
+};
+
+struct PipelineLayoutNull {
+  Device device;
+  PipelineLayoutCreateInfo info;
+};
+
+struct FramebufferNull {
+  Device device;
+  FramebufferCreateInfo info;
+};
+
+struct BufferNull {
+  Device device;
+  BufferUsageFlags usage;
+  MemoryUsage memory_usage;
+  std::vector<uint8_t> data;
+  bool mapped = false;
+};
+
+struct CommandPoolNull {
+  Device device;
+  CommandPoolCreateFlags flags;
+};
+
+struct CommandBufferNull {
+  Device device;
+  CommandPool pool;
+  CommandBufferLevel level = CommandBufferLevel::kPrimary;
+  bool recording = false;
+  bool in_render_pass = false;
+  // Secondary command buffer begun inside a render pass.
+  bool continues_render_pass = false;
+  // Render pass begun with SubpassContents::kSecondaryCommandBuffers.
+  bool secondary_contents = false;
+};
+
+struct SemaphoreNull {
+  Device device;
+};
+
+struct FenceNull {
+  Device device;
+  bool signaled = false;
+};
+
+struct DescriptorSetLayoutNull {
+  Device device;
+  DescriptorSetLayoutCreateInfo info;
+};
+
+struct DescriptorSetPoolNull {
+  Device device;
+  uint32_t max_sets;
+  std::vector<DescriptorSet> sets;
+};
+
+struct DescriptorSetNull {
+  DescriptorSetPool pool;
+  DescriptorSetLayout layout;
+};
+
+struct ImageNull {
+  Device device;
+  ImageCreateInfo info;
+  MemoryHeap heap = kInvalidHandle;
+  uint64_t offset = 0;
+};
+
+struct MemoryHeapNull {
+  Device device;
+  uint64_t size;
+  uint32_t memory_type_bits;
+};
+
+struct ImageViewNull {
+  Device device;
+  Image image;
+};
+
+struct SamplerNull {
+  Device device;
+  SamplerCreateInfo info;
+};
+
+struct ShaderModuleNull {
+  Device device;
+  size_t size;
+};
+
+struct PipelineCacheNull {
+  Device device;
+  std::vector<uint8_t> data;
+};
+
+// Copies happen immediately, a flush completes the batch.
+struct UploadQueueNull {
+  Device device;
+  UploadToken next_token = 1;
+  UploadToken completed = 0;
+  bool pending = false;
+};
+
+namespace Null {
+
+// Every entry point of the RenderAPI, used to generate the call counters.
+#define RENDER_API_NULL_CALLS(X) \
+  X(Create)                      \
+  X(Destroy)                     \
+  X(CreateDevice)                \
+  X(DestroyDevice)               \
+  X(DeviceWaitIdle)              \
+  X(CreateSwapChain)             \
+  X(DestroySwapChain)            \
+  X(GetSwapChainLength)          \
+  X(AcquireNextImage)            \
+  X(GetSwapChainImageFormat)     \
+  X(GetSwapChainImageView)       \
+  X(CreatePipelineLayout)        \
+  X(DestroyPipelineLayout)       \
+  X(CreateGraphicsPipeline)      \
+  X(DestroyGraphicsPipeline)     \
+  X(CreateRenderPass)            \
+  X(DestroyRenderPass)           \
+  X(GetRenderPassCompatibility)  \
+  X(CreateFramebuffer)           \
+  X(DestroyFramebuffer)          \
+  X(CreateBuffer)                \
+  X(DestroyBuffer)               \
+  X(MapBuffer)                   \
+  X(UnmapBuffer)                 \
+  X(CreateCommandPool)           \
+  X(DestroyCommandPool)          \
+  X(CreateCommandBuffer)         \
+  X(DestroyCommandBuffer)        \
+  X(CmdBegin)                    \
+  X(CmdEnd)                      \
+  X(CmdSetViewport)              \
+  X(CmdSetScissor)               \
+  X(CmdBeginRenderPass)          \
+  X(CmdEndRenderPass)            \
+  X(CmdBindPipeline)             \
+  X(CmdBindVertexBuffers)        \
+  X(CmdBindDescriptorSets)       \
+  X(CmdPushConstants)            \
+  X(CmdBindIndexBuffer)          \
+  X(CmdDraw)                     \
+  X(CmdDrawIndexed)              \
+  X(CmdCopyBuffer)               \
+  X(CmdPipelineBarrier)          \
+  X(CmdExecuteCommands)          \
+  X(CreateSemaphore)             \
+  X(DestroySemaphore)            \
+  X(CreateFence)                 \
+  X(DestroyFence)                \
+  X(WaitForFences)               \
+  X(ResetFences)                 \
+  X(CreateDescriptorSetLayout)   \
+  X(DestroyDescriptorSetLayout)  \
+  X(CreateDescriptorSetPool)     \
+  X(DestroyDescriptorSetPool)    \
+  X(AllocateDescriptorSets)      \
+  X(UpdateDescriptorSets)        \
+  X(QueueSubmit)                 \
+  X(QueuePresent)                \
+  X(CreateImage)                 \
+  X(DestroyImage)                \
+  X(CreateShaderModule)          \
+  X(DestroyShaderModule)         \
+  X(StageCopyDataToBuffer)       \
+  X(StageCopyDataToImage)        \
+  X(CreateImageView)             \
+  X(DestroyImageView)            \
+  X(CreateSampler)               \
+  X(DestroySampler)              \
+  X(CreateUploadQueue)           \
+  X(DestroyUploadQueue)          \
+  X(UploadToBuffer)              \
+  X(UploadToImage)               \
+  X(FlushUploads)                \
+  X(IsUploadComplete)            \
+  X(WaitForUpload)               \
+  X(CreatePipelineCache)         \
+  X(DestroyPipelineCache)        \
+  X(GetPipelineCacheData)        \
+  X(GetImageMemoryRequirements)  \
+  X(CreateMemoryHeap)            \
+  X(DestroyMemoryHeap)           \
+  X(CreateAliasedImage)
+
+#define RENDER_API_NULL_CALL_ENUM(name) k##name,
+enum class Call : uint32_t {
+  RENDER_API_NULL_CALLS(RENDER_API_NULL_CALL_ENUM) kCount
+};
+#undef RENDER_API_NULL_CALL_ENUM
+
+enum class Object : uint32_t {
+  kInstance,
+  kDevice,
+  kSwapChain,
+  kRenderPass,
+  kGraphicsPipeline,
+  kPipelineLayout,
+  kFramebuffer,
+  kBuffer,
+  kCommandPool,
+  kCommandBuffer,
+  kSemaphore,
+  kFence,
+  kDescriptorSetLayout,
+  kDescriptorSetPool,
+  kDescriptorSet,
+  kImage,
+  kImageView,
+  kSampler,
+  kShaderModule,
+  kUploadQueue,
+  kPipelineCache,
+  kMemoryHeap,
+  kCount
+};
+
+struct ObjectCounters {
+  uint64_t created = 0;
+  uint64_t destroyed = 0;
+
+  uint64_t Alive() const { return created - destroyed; }
+};
+
+// Call counters.
+uint64_t GetCallCount(Call call);
+const char* GetCallName(Call call);
+void ResetCallCounts();
+
+// Object lifetimes.
+ObjectCounters GetObjectCounters(Object object);
+const char* GetObjectName(Object object);
+
+// Prints every object type that still has live objects and returns how many
+// objects are alive in total.
+uint64_t ReportLeaks();
+
+}  // namespace Null
+}  // namespace RenderAPI
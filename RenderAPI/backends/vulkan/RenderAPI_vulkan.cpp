@@ -6,7 +6,7 @@
 #include <stdexcept>
 #include <vector>
 #include "detail/RenderAPI_vulkan_detail.h"
-#include "generational/generational_vector.h"
+#include "generational/concurrent_generational_vector.h"
 
 // Remove windows defined CreateSemaphore macro.
 #ifdef CreateSemaphore
@@ -15,20 +15,41 @@
 
 namespace RenderAPI {
 namespace {
-GenerationalVector<InstanceVk> instances_;
-GenerationalVector<DeviceVk> devices_;
-GenerationalVector<SwapChainVk> swapchains_;
-GenerationalVector<RenderPassVk> render_passes_;
-GenerationalVector<GraphicsPipelineVk> graphic_pipelines_;
-GenerationalVector<FramebufferVk> framebuffers_;
-GenerationalVector<BufferVk> buffers_;
-GenerationalVector<CommandPoolVk> command_pools_;
-GenerationalVector<CommandBufferVk> command_buffers_;
-GenerationalVector<SemaphoreVk> semaphores_;
-GenerationalVector<FenceVk> fences_;
-GenerationalVector<DescriptorSetLayoutVk> descriptor_set_layouts_;
-GenerationalVector<DescriptorSetPoolVk> descriptor_set_pools_;
-GenerationalVector<ImageVk> images_;
+ConcurrentGenerationalVector<InstanceVk> instances_;
+ConcurrentGenerationalVector<DeviceVk> devices_;
+ConcurrentGenerationalVector<SwapChainVk> swapchains_;
+ConcurrentGenerationalVector<RenderPassVk> render_passes_;
+ConcurrentGenerationalVector<GraphicsPipelineVk> graphic_pipelines_;
+ConcurrentGenerationalVector<FramebufferVk> framebuffers_;
+ConcurrentGenerationalVector<BufferVk> buffers_;
+ConcurrentGenerationalVector<CommandPoolVk> command_pools_;
+ConcurrentGenerationalVector<CommandBufferVk> command_buffers_;
+ConcurrentGenerationalVector<SemaphoreVk> semaphores_;
+ConcurrentGenerationalVector<FenceVk> fences_;
+ConcurrentGenerationalVector<DescriptorSetLayoutVk> descriptor_set_layouts_;
+ConcurrentGenerationalVector<DescriptorSetPoolVk> descriptor_set_pools_;
+ConcurrentGenerationalVector<ImageVk> images_;
+ConcurrentGenerationalVector<UploadQueueVk> upload_queues_;
+ConcurrentGenerationalVector<PipelineCacheVk> pipeline_caches_;
+ConcurrentGenerationalVector<MemoryHeapVk> memory_heaps_;
+
+// Upload destinations (transfer dst usage) are shared between the graphics
+// and the transfer queue families so uploads don't need queue ownership
+// transfers. Everything else stays exclusive to keep compression and layout
+// optimizations.
+void SetSharingMode(const DeviceVk& device, bool transfer_dst,
+                    VkSharingMode& mode, uint32_t& family_count,
+                    const uint32_t*& families, uint32_t (&storage)[2]) {
+  if (!transfer_dst || device.indices.transfer == device.indices.graphics) {
+    mode = VK_SHARING_MODE_EXCLUSIVE;
+    return;
+  }
+  storage[0] = static_cast<uint32_t>(device.indices.graphics);
+  storage[1] = static_cast<uint32_t>(device.indices.transfer);
+  mode = VK_SHARING_MODE_CONCURRENT;
+  family_count = 2;
+  families = storage;
+}
 }  // namespace
 
 Instance Create(const char* const* extensions, uint32_t extensions_count) {
@@ -99,6 +120,8 @@ Device CreateDevice(Instance instance_handle) {
                    &device.graphics_queue);
   vkGetDeviceQueue(device.device, device_indices.presentation, 0,
                    &device.present_queue);
+  vkGetDeviceQueue(device.device, device_indices.transfer, 0,
+                   &device.transfer_queue);
 
   // Create Vulkan Memory Allocator.
   VmaAllocatorCreateInfo allocatorInfo = {};
@@ -260,6 +283,7 @@ RenderPass CreateRenderPass(Device device_handle,
 
   RenderPassVk pass;
   pass.device = device_handle;
+  pass.compatibility = GetRenderPassCompatibility(info);
 
   std::vector<VkAttachmentReference>
       color_attachment_refs;  //(info.color_attachments.size());
@@ -331,6 +355,10 @@ void DestroyRenderPass(RenderPass pass_handle) {
   render_passes_.Destroy(pass_handle);
 }
 
+RenderPassCompatibility GetRenderPassCompatibility(RenderPass pass) {
+  return render_passes_[pass].compatibility;
+}
+
 PipelineLayout CreatePipelineLayout(Device device,
                                     const PipelineLayoutCreateInfo& info) {
   VkPipelineLayout layout;
@@ -370,9 +398,10 @@ void DestroyShaderModule(Device device, ShaderModule module) {
                         reinterpret_cast<VkShaderModule>(module), nullptr);
 }
 
-GraphicsPipeline CreateGraphicsPipeline(
-    Device device_handle, RenderPass pass_handle,
-    const GraphicsPipelineCreateInfo& info) {
+GraphicsPipeline CreateGraphicsPipeline(Device device_handle,
+                                        RenderPass pass_handle,
+                                        const GraphicsPipelineCreateInfo& info,
+                                        PipelineCache cache) {
   assert((std::find(info.states.dynamic_states.states.cbegin(),
                     info.states.dynamic_states.states.cend(),
                     RenderAPI::DynamicState::kViewport) !=
@@ -562,7 +591,10 @@ GraphicsPipeline CreateGraphicsPipeline(
   pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;  // Optional
   pipelineInfo.basePipelineIndex = -1;               // Optional
 
-  if (vkCreateGraphicsPipelines(device.device, VK_NULL_HANDLE, 1, &pipelineInfo,
+  VkPipelineCache pipeline_cache = (cache == kInvalidHandle)
+                                       ? VK_NULL_HANDLE
+                                       : pipeline_caches_[cache].cache;
+  if (vkCreateGraphicsPipelines(device.device, pipeline_cache, 1, &pipelineInfo,
                                 nullptr, &pipeline.pipeline) != VK_SUCCESS) {
     throw std::runtime_error("failed to create graphics pipeline!");
   }
@@ -585,6 +617,63 @@ void DestroyGraphicsPipeline(GraphicsPipeline pipeline_handle) {
   graphic_pipelines_.Destroy(pipeline_handle);
 }
 
+PipelineCache CreatePipelineCache(Device device_handle, const void* data,
+                                  size_t size, bool* discarded) {
+  auto& device = devices_[device_handle];
+
+  // Only hand the driver data that was produced by this device and driver.
+  bool compatible = false;
+  if (data && size >= sizeof(VkPipelineCacheHeaderVersionOne)) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device.physical_device, &properties);
+    VkPipelineCacheHeaderVersionOne header;
+    memcpy(&header, data, sizeof(header));
+    compatible =
+        header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        header.vendorID == properties.vendorID &&
+        header.deviceID == properties.deviceID &&
+        memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID,
+               VK_UUID_SIZE) == 0;
+  }
+  if (discarded) {
+    *discarded = data && size > 0 && !compatible;
+  }
+  if (!compatible) {
+    data = nullptr;
+    size = 0;
+  }
+
+  VkPipelineCacheCreateInfo create_info = {
+      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+  create_info.initialDataSize = size;
+  create_info.pInitialData = data;
+
+  PipelineCacheVk cache;
+  cache.device = device_handle;
+  if (vkCreatePipelineCache(device.device, &create_info, nullptr,
+                            &cache.cache) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create pipeline cache!");
+  }
+  return pipeline_caches_.Create(std::move(cache));
+}
+
+void DestroyPipelineCache(PipelineCache cache_handle) {
+  auto& cache = pipeline_caches_[cache_handle];
+  vkDestroyPipelineCache(devices_[cache.device].device, cache.cache, nullptr);
+  pipeline_caches_.Destroy(cache_handle);
+}
+
+std::vector<uint8_t> GetPipelineCacheData(PipelineCache cache_handle) {
+  auto& cache = pipeline_caches_[cache_handle];
+  VkDevice device = devices_[cache.device].device;
+  size_t size = 0;
+  vkGetPipelineCacheData(device, cache.cache, &size, nullptr);
+  std::vector<uint8_t> data(size);
+  vkGetPipelineCacheData(device, cache.cache, &size, data.data());
+  data.resize(size);
+  return data;
+}
+
 void DestroyFramebuffer(Framebuffer buffer_handle) {
   auto& buffer = framebuffers_[buffer_handle];
   vkDestroyFramebuffer(devices_[buffer.device].device, buffer.buffer, nullptr);
@@ -614,14 +703,15 @@ void DestroyCommandPool(CommandPool pool_handle) {
   command_pools_.Destroy(pool_handle);
 }
 
-CommandBuffer CreateCommandBuffer(CommandPool pool_handle) {
+CommandBuffer CreateCommandBuffer(CommandPool pool_handle,
+                                  CommandBufferLevel level) {
   auto& pool = command_pools_[pool_handle];
   auto& device = devices_[pool.device];
 
   VkCommandBufferAllocateInfo allocInfo = {};
   allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
   allocInfo.commandPool = pool.pool;
-  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.level = static_cast<VkCommandBufferLevel>(level);
   allocInfo.commandBufferCount = 1;
 
   CommandBufferVk buffer;
@@ -654,6 +744,29 @@ void CmdBegin(CommandBuffer buffer_handle) {
   }
 }
 
+void CmdBegin(CommandBuffer buffer_handle,
+              const CommandBufferInheritanceInfo& inheritance) {
+  auto& buffer = command_buffers_[buffer_handle];
+  VkCommandBufferInheritanceInfo inheritance_info = {};
+  inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritance_info.renderPass = render_passes_[inheritance.pass].pass;
+  inheritance_info.subpass = inheritance.subpass;
+  if (inheritance.framebuffer != kInvalidHandle) {
+    inheritance_info.framebuffer =
+        framebuffers_[inheritance.framebuffer].buffer;
+  }
+
+  VkCommandBufferBeginInfo beginInfo = {};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                    VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+  beginInfo.pInheritanceInfo = &inheritance_info;
+
+  if (vkBeginCommandBuffer(buffer.buffer, &beginInfo) != VK_SUCCESS) {
+    throw std::runtime_error("failed to begin recording command buffer!");
+  }
+}
+
 void CmdEnd(CommandBuffer buffer_handle) {
   auto& buffer = command_buffers_[buffer_handle];
   if (vkEndCommandBuffer(buffer.buffer) != VK_SUCCESS) {
@@ -673,7 +786,7 @@ void CmdBeginRenderPass(CommandBuffer buffer_handle,
   renderPassInfo.pClearValues =
       reinterpret_cast<const VkClearValue*>(info.clear_values);
   vkCmdBeginRenderPass(command_buffers_[buffer_handle].buffer, &renderPassInfo,
-                       VK_SUBPASS_CONTENTS_INLINE);
+                       static_cast<VkSubpassContents>(info.contents));
 }
 
 void CmdEndRenderPass(CommandBuffer buffer_handle) {
@@ -763,6 +876,25 @@ void CmdCopyBuffer(CommandBuffer cmd, Buffer src, Buffer dst,
                   reinterpret_cast<const VkBufferCopy*>(regions));
 }
 
+void CmdPipelineBarrier(CommandBuffer cmd, const PipelineBarrier& barrier) {
+  VkMemoryBarrier memory_barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  memory_barrier.srcAccessMask = barrier.src_access;
+  memory_barrier.dstAccessMask = barrier.dst_access;
+  vkCmdPipelineBarrier(command_buffers_[cmd].buffer, barrier.src_stages,
+                       barrier.dst_stages, 0, 1, &memory_barrier, 0, nullptr, 0,
+                       nullptr);
+}
+
+void CmdExecuteCommands(CommandBuffer buffer, uint32_t count,
+                        const CommandBuffer* buffers) {
+  // Grows with recording threads times passes, so it isn't bounded.
+  std::vector<VkCommandBuffer> cmds(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    cmds[i] = command_buffers_[buffers[i]].buffer;
+  }
+  vkCmdExecuteCommands(command_buffers_[buffer].buffer, count, cmds.data());
+}
+
 Semaphore CreateSemaphore(Device device_handle) {
   auto& device = devices_[device_handle];
   SemaphoreVk semaphore;
@@ -823,41 +955,72 @@ void ResetFences(const Fence* fences, uint32_t count) {
 }
 
 void QueueSubmit(Device device, const SubmitInfo& info, Fence fence) {
-  VkSubmitInfo submitInfo = {};
-  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-  VkSemaphore waitSemaphores[256] = {};
-  std::vector<VkPipelineStageFlags> waitStages(
-      info.wait_semaphores_count,
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
-  assert(info.wait_semaphores_count <= 256);
-  for (uint32_t i = 0; i < info.wait_semaphores_count; ++i) {
-    waitSemaphores[i] = semaphores_[info.wait_semaphores[i]].semaphore;
+  QueueSubmit(device, &info, 1, fence);
+}
+
+void QueueSubmit(Device device, const SubmitInfo* infos, uint32_t count,
+                 Fence fence) {
+  // All batches share flat arrays so the submission doesn't allocate once they
+  // have grown to the largest frame. Kept per thread as any thread may submit.
+  struct SubmitScratch {
+    std::vector<VkSubmitInfo> submits;
+    std::vector<VkSemaphore> wait_semaphores;
+    std::vector<VkPipelineStageFlags> wait_stages;
+    std::vector<VkSemaphore> signal_semaphores;
+    std::vector<VkCommandBuffer> cmds;
+  };
+  thread_local SubmitScratch scratch;
+  size_t total_waits = 0;
+  size_t total_signals = 0;
+  size_t total_cmds = 0;
+  for (uint32_t submit = 0; submit < count; ++submit) {
+    total_waits += infos[submit].wait_semaphores_count;
+    total_signals += infos[submit].signal_semaphores_count;
+    total_cmds += infos[submit].command_buffers_count;
   }
+  scratch.submits.assign(count, VkSubmitInfo{});
+  scratch.wait_semaphores.resize(total_waits);
+  scratch.wait_stages.resize(total_waits);
+  scratch.signal_semaphores.resize(total_signals);
+  scratch.cmds.resize(total_cmds);
+
+  VkSemaphore* wait_semaphores = scratch.wait_semaphores.data();
+  VkPipelineStageFlags* wait_stages = scratch.wait_stages.data();
+  VkSemaphore* signal_semaphores = scratch.signal_semaphores.data();
+  VkCommandBuffer* cmds = scratch.cmds.data();
+  for (uint32_t submit = 0; submit < count; ++submit) {
+    const SubmitInfo& info = infos[submit];
+    VkSubmitInfo& submit_info = scratch.submits[submit];
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+    submit_info.pWaitSemaphores = wait_semaphores;
+    submit_info.pWaitDstStageMask = wait_stages;
+    submit_info.waitSemaphoreCount = info.wait_semaphores_count;
+    for (uint32_t i = 0; i < info.wait_semaphores_count; ++i) {
+      *wait_semaphores++ = semaphores_[info.wait_semaphores[i]].semaphore;
+      *wait_stages++ = info.wait_stages
+                           ? static_cast<VkPipelineStageFlags>(
+                                 info.wait_stages[i])
+                           : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    }
 
-  submitInfo.pWaitSemaphores = waitSemaphores;
-  submitInfo.pWaitDstStageMask = waitStages.data();
-  submitInfo.waitSemaphoreCount = info.wait_semaphores_count;
-
-  VkCommandBuffer cmds[256] = {};
-  for (uint32_t i = 0; i < info.command_buffers_count; ++i) {
-    cmds[i] = command_buffers_[info.command_buffers[i]].buffer;
-  }
-  submitInfo.commandBufferCount = info.command_buffers_count;
-  submitInfo.pCommandBuffers = cmds;
+    submit_info.pCommandBuffers = cmds;
+    submit_info.commandBufferCount = info.command_buffers_count;
+    for (uint32_t i = 0; i < info.command_buffers_count; ++i) {
+      *cmds++ = command_buffers_[info.command_buffers[i]].buffer;
+    }
 
-  VkSemaphore signalSemaphores[256] = {};
-  assert(info.signal_semaphores_count <= 256);
-  for (uint32_t i = 0; i < info.signal_semaphores_count; ++i) {
-    signalSemaphores[i] = semaphores_[info.signal_semaphores[i]].semaphore;
+    submit_info.pSignalSemaphores = signal_semaphores;
+    submit_info.signalSemaphoreCount = info.signal_semaphores_count;
+    for (uint32_t i = 0; i < info.signal_semaphores_count; ++i) {
+      *signal_semaphores++ = semaphores_[info.signal_semaphores[i]].semaphore;
+    }
   }
-  submitInfo.signalSemaphoreCount = info.signal_semaphores_count;
-  submitInfo.pSignalSemaphores = signalSemaphores;
 
   const VkFence vk_fence =
       (fence == kInvalidHandle) ? VK_NULL_HANDLE : fences_[fence].fence;
-  if (vkQueueSubmit(devices_[device].graphics_queue, 1, &submitInfo,
-                    vk_fence) != VK_SUCCESS) {
+  if (vkQueueSubmit(devices_[device].graphics_queue, count,
+                    scratch.submits.data(), vk_fence) != VK_SUCCESS) {
     throw std::runtime_error("failed to submit draw command buffer!");
   }
 }
@@ -893,6 +1056,11 @@ Buffer CreateBuffer(Device device, BufferUsageFlags usage, uint64_t size,
   VkBufferCreateInfo bufferInfo = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
   bufferInfo.size = size;
   bufferInfo.usage = usage | MemoryUsageToVulkan(memory_usage);
+  uint32_t families[2];
+  SetSharingMode(device_ref,
+                 (bufferInfo.usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) != 0,
+                 bufferInfo.sharingMode, bufferInfo.queueFamilyIndexCount,
+                 bufferInfo.pQueueFamilyIndices, families);
   VmaAllocationCreateInfo allocInfo = {};
   allocInfo.usage = MemoryUsageToVulkanMemoryAllocator(memory_usage);
   allocInfo.preferredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
@@ -1065,7 +1233,9 @@ void UpdateDescriptorSets(Device device, uint32_t descriptor_write_count,
     write_sets[i].pTexelBufferView = nullptr;
     write_sets[i].pBufferInfo = nullptr;
     if (descriptor_writes[i].type == DescriptorType::kUniformBuffer ||
-        descriptor_writes[i].type == DescriptorType::kStorageBuffer) {
+        descriptor_writes[i].type == DescriptorType::kStorageBuffer ||
+        descriptor_writes[i].type == DescriptorType::kUniformBufferDynamic ||
+        descriptor_writes[i].type == DescriptorType::kStorageBufferDynamic) {
       write_sets[i].pBufferInfo = &buffers[buffer_offset];
       for (uint32_t j = 0; j < descriptor_writes[i].descriptor_count; ++j) {
         assert(buffer_offset < 20);
@@ -1098,12 +1268,12 @@ void UpdateDescriptorSets(Device device, uint32_t descriptor_write_count,
                          write_sets, descriptor_copy_count, copies);
 }
 
-Image CreateImage(Device device, const ImageCreateInfo& info) {
-  auto& device_ref = devices_[device];
-  ImageVk image;
-  image.device = device;
-
-  VkImageCreateInfo imageInfo = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+namespace {
+void FillImageCreateInfo(const DeviceVk& device_ref,
+                         const ImageCreateInfo& info,
+                         VkImageCreateInfo& imageInfo,
+                         uint32_t (&families)[2]) {
+  imageInfo = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
   imageInfo.imageType = static_cast<VkImageType>(info.type);
   imageInfo.extent.width = info.extent.width;
   imageInfo.extent.height = info.extent.height;
@@ -1114,9 +1284,23 @@ Image CreateImage(Device device, const ImageCreateInfo& info) {
   imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
   imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
   imageInfo.usage = info.usage;
-  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  SetSharingMode(device_ref,
+                 (imageInfo.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0,
+                 imageInfo.sharingMode, imageInfo.queueFamilyIndexCount,
+                 imageInfo.pQueueFamilyIndices, families);
   imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
   imageInfo.flags = info.flags;
+}
+}  // namespace
+
+Image CreateImage(Device device, const ImageCreateInfo& info) {
+  auto& device_ref = devices_[device];
+  ImageVk image;
+  image.device = device;
+
+  VkImageCreateInfo imageInfo;
+  uint32_t families[2];
+  FillImageCreateInfo(device_ref, info, imageInfo, families);
 
   VmaAllocationCreateInfo imageAllocCreateInfo = {};
   imageAllocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
@@ -1131,10 +1315,100 @@ Image CreateImage(Device device, const ImageCreateInfo& info) {
 void DestroyImage(Image image) {
   auto& ref = images_[image];
   auto& device_ref = devices_[ref.device];
-  vmaDestroyImage(device_ref.allocator, ref.image, ref.allocation);
+  if (ref.allocation == VK_NULL_HANDLE) {
+    vkDestroyImage(device_ref.device, ref.image, nullptr);
+  } else {
+    vmaDestroyImage(device_ref.allocator, ref.image, ref.allocation);
+  }
   images_.Destroy(image);
 }
 
+MemoryRequirements GetImageMemoryRequirements(Device device,
+                                              const ImageCreateInfo& info) {
+  auto& device_ref = devices_[device];
+  VkImageCreateInfo imageInfo;
+  uint32_t families[2];
+  FillImageCreateInfo(device_ref, info, imageInfo, families);
+
+  // Query with a throwaway image, it never gets memory bound.
+  VkImage image;
+  if (vkCreateImage(device_ref.device, &imageInfo, nullptr, &image) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create image!");
+  }
+  VkMemoryRequirements requirements;
+  vkGetImageMemoryRequirements(device_ref.device, image, &requirements);
+  vkDestroyImage(device_ref.device, image, nullptr);
+
+  MemoryRequirements result;
+  result.size = requirements.size;
+  result.alignment = requirements.alignment;
+  result.memory_type_bits = requirements.memoryTypeBits;
+  return result;
+}
+
+MemoryHeap CreateMemoryHeap(Device device, uint64_t size,
+                            uint32_t memory_type_bits) {
+  auto& device_ref = devices_[device];
+  VkMemoryRequirements requirements = {};
+  requirements.size = size;
+  requirements.alignment = 1;
+  requirements.memoryTypeBits = memory_type_bits;
+
+  VmaAllocationCreateInfo alloc_create_info = {};
+  alloc_create_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+  alloc_create_info.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+
+  MemoryHeapVk heap;
+  heap.device = device;
+  VmaAllocationInfo alloc_info;
+  if (vmaAllocateMemory(device_ref.allocator, &requirements,
+                        &alloc_create_info, &heap.allocation,
+                        &alloc_info) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate memory heap!");
+  }
+  heap.memory = alloc_info.deviceMemory;
+  heap.offset = alloc_info.offset;
+  heap.size = size;
+  heap.memory_type = alloc_info.memoryType;
+  return memory_heaps_.Create(std::move(heap));
+}
+
+void DestroyMemoryHeap(MemoryHeap heap_handle) {
+  auto& heap = memory_heaps_[heap_handle];
+  vmaFreeMemory(devices_[heap.device].allocator, heap.allocation);
+  memory_heaps_.Destroy(heap_handle);
+}
+
+Image CreateAliasedImage(Device device, const ImageCreateInfo& info,
+                         MemoryHeap heap_handle, uint64_t offset) {
+  auto& device_ref = devices_[device];
+  const auto& heap = memory_heaps_[heap_handle];
+  ImageVk image;
+  image.device = device;
+
+  VkImageCreateInfo imageInfo;
+  uint32_t families[2];
+  FillImageCreateInfo(device_ref, info, imageInfo, families);
+  if (vkCreateImage(device_ref.device, &imageInfo, nullptr, &image.image) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create image!");
+  }
+
+  VkMemoryRequirements requirements;
+  vkGetImageMemoryRequirements(device_ref.device, image.image, &requirements);
+  assert((requirements.memoryTypeBits & (1u << heap.memory_type)) &&
+         "Image is incompatible with the heap's memory type!");
+  assert(offset % requirements.alignment == 0 && "Misaligned image offset!");
+  assert(offset + requirements.size <= heap.size && "Image exceeds the heap!");
+  if (vkBindImageMemory(device_ref.device, image.image, heap.memory,
+                        heap.offset + offset) != VK_SUCCESS) {
+    vkDestroyImage(device_ref.device, image.image, nullptr);
+    throw std::runtime_error("failed to bind image memory!");
+  }
+  return images_.Create(std::move(image));
+}
+
 VkCommandBuffer BeginSingleTimeCommands(DeviceVk& device, VkCommandPool pool) {
   VkCommandBufferAllocateInfo allocInfo = {};
   allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -1180,9 +1454,13 @@ void EndSingleTimeCommands(DeviceVk& device, VkCommandPool pool,
   vkFreeCommandBuffers(device.device, pool, 1, &commandBuffer);
 }
 
-void RecordTransitionImageLayout(VkCommandBuffer commandBuffer, VkImage image,
-                                 VkImageLayout oldLayout,
-                                 VkImageLayout newLayout) {
+// |read_stage| is the stage that consumes the image after the transition to
+// VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL. Transfer queues can't name shader
+// stages, they pass VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT instead.
+void RecordTransitionImageLayout(
+    VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout,
+    VkImageLayout newLayout,
+    VkPipelineStageFlags read_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) {
   VkImageMemoryBarrier barrier = {};
   barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
   barrier.oldLayout = oldLayout;
@@ -1209,10 +1487,13 @@ void RecordTransitionImageLayout(VkCommandBuffer commandBuffer, VkImage image,
   } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
              newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
     barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.dstAccessMask =
+        (read_stage == VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT)
+            ? 0
+            : VK_ACCESS_SHADER_READ_BIT;
 
     sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    destinationStage = read_stage;
   } else {
     throw std::invalid_argument("unsupported layout transition!");
   }
@@ -1288,6 +1569,272 @@ void StageCopyDataToBuffer(CommandPool pool, Buffer buffer, const void* data,
   vmaDestroyBuffer(device_ref.allocator, staging_buffer, allocation);
 }
 
+namespace {
+constexpr uint32_t kMaxUploadBatches = 4;
+// Satisfies the buffer offset requirements of every (compressed) format.
+constexpr uint64_t kStagingAlignment = 16;
+
+void RetireUploadBatch(UploadQueueVk& queue, DeviceVk& device,
+                       UploadBatchVk& batch) {
+  vkWaitForFences(device.device, 1, &batch.fence, VK_TRUE,
+                  std::numeric_limits<uint64_t>::max());
+  vkResetFences(device.device, 1, &batch.fence);
+  for (auto& it : batch.dedicated) {
+    vmaDestroyBuffer(device.allocator, it.first, it.second);
+  }
+  batch.dedicated.clear();
+  queue.tail = batch.ring_end;
+  queue.completed = batch.token;
+  batch.token = 0;
+  batch.submitted = false;
+  queue.oldest = (queue.oldest + 1) % kMaxUploadBatches;
+}
+
+bool RetireOldestUploadBatch(UploadQueueVk& queue, DeviceVk& device,
+                             bool wait) {
+  UploadBatchVk& batch = queue.batches[queue.oldest];
+  if (!batch.submitted) {
+    return false;
+  }
+  if (!wait && vkGetFenceStatus(device.device, batch.fence) != VK_SUCCESS) {
+    return false;
+  }
+  RetireUploadBatch(queue, device, batch);
+  return true;
+}
+
+void SubmitUploadBatch(UploadQueueVk& queue) {
+  UploadBatchVk& batch = queue.batches[queue.current];
+  if (batch.token == 0) {
+    return;
+  }
+  vkEndCommandBuffer(batch.cmd);
+
+  VkSubmitInfo submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &batch.cmd;
+  if (vkQueueSubmit(queue.queue, 1, &submit_info, batch.fence) != VK_SUCCESS) {
+    throw std::runtime_error("failed to submit uploads!");
+  }
+  batch.submitted = true;
+  batch.ring_end = queue.head;
+  queue.current = (queue.current + 1) % kMaxUploadBatches;
+}
+
+// Returns the batch copies are recorded into, starting one if needed.
+UploadBatchVk& RecordingUploadBatch(UploadQueueVk& queue, DeviceVk& device) {
+  UploadBatchVk& batch = queue.batches[queue.current];
+  if (batch.token != 0) {
+    return batch;
+  }
+  if (batch.submitted) {
+    // All batches are in flight, wait for the oldest one which is this one.
+    RetireOldestUploadBatch(queue, device, true);
+  }
+  vkResetCommandBuffer(batch.cmd, 0);
+  VkCommandBufferBeginInfo begin_info = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkBeginCommandBuffer(batch.cmd, &begin_info);
+  batch.token = queue.next_token++;
+  return batch;
+}
+
+// Copies |data| to staging memory, returning the buffer and offset to copy
+// from.
+VkBuffer StageUpload(UploadQueueVk& queue, DeviceVk& device, const void* data,
+                     uint64_t size, uint64_t& out_offset) {
+  const uint64_t aligned_size =
+      (size + kStagingAlignment - 1) & ~(kStagingAlignment - 1);
+  if (aligned_size > queue.size) {
+    // Too large for the ring, give it a buffer of its own that is released
+    // with the batch.
+    VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    buffer_info.size = size;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    VmaAllocationCreateInfo alloc_info = {};
+    alloc_info.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    VkBuffer buffer;
+    VmaAllocation allocation;
+    vmaCreateBuffer(device.allocator, &buffer_info, &alloc_info, &buffer,
+                    &allocation, nullptr);
+    void* mapped_data;
+    vmaMapMemory(device.allocator, allocation, &mapped_data);
+    memcpy(mapped_data, data, static_cast<size_t>(size));
+    vmaUnmapMemory(device.allocator, allocation);
+    RecordingUploadBatch(queue, device).dedicated.emplace_back(buffer,
+                                                               allocation);
+    out_offset = 0;
+    return buffer;
+  }
+
+  // Wrap instead of splitting the copy.
+  uint64_t position = queue.head % queue.size;
+  if (position + aligned_size > queue.size) {
+    queue.head += queue.size - position;
+    position = 0;
+  }
+  // Make room by retiring batches, submitting the current one if it holds
+  // the space we need.
+  while (queue.head + aligned_size - queue.tail > queue.size) {
+    if (RetireOldestUploadBatch(queue, device, true)) {
+      continue;
+    }
+    if (queue.batches[queue.current].token != 0) {
+      SubmitUploadBatch(queue);
+      continue;
+    }
+    // Nothing is recording or in flight, the ring is empty.
+    queue.tail = queue.head;
+  }
+  // Begin recording before advancing the head so the space belongs to it.
+  RecordingUploadBatch(queue, device);
+  memcpy(queue.mapped + position, data, static_cast<size_t>(size));
+  queue.head += aligned_size;
+  out_offset = position;
+  return queue.staging;
+}
+}  // namespace
+
+UploadQueue CreateUploadQueue(Device device_handle, uint64_t staging_size) {
+  auto& device = devices_[device_handle];
+  UploadQueueVk queue;
+  queue.device = device_handle;
+  queue.queue = device.transfer_queue;
+  queue.graphics_queue = device.indices.transfer == device.indices.graphics;
+  queue.size = staging_size;
+
+  VkCommandPoolCreateInfo pool_info = {
+      VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+  pool_info.queueFamilyIndex = device.indices.transfer;
+  pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+                    VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  if (vkCreateCommandPool(device.device, &pool_info, nullptr, &queue.pool) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create upload command pool!");
+  }
+
+  queue.batches.resize(kMaxUploadBatches);
+  for (auto& batch : queue.batches) {
+    VkCommandBufferAllocateInfo alloc_info = {
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.commandPool = queue.pool;
+    alloc_info.commandBufferCount = 1;
+    vkAllocateCommandBuffers(device.device, &alloc_info, &batch.cmd);
+
+    VkFenceCreateInfo fence_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+    if (vkCreateFence(device.device, &fence_info, nullptr, &batch.fence) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to create upload fence!");
+    }
+  }
+
+  VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+  buffer_info.size = staging_size;
+  buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+  VmaAllocationCreateInfo alloc_info = {};
+  alloc_info.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+  alloc_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+  VmaAllocationInfo allocation_info;
+  if (vmaCreateBuffer(device.allocator, &buffer_info, &alloc_info,
+                      &queue.staging, &queue.allocation,
+                      &allocation_info) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create staging buffer!");
+  }
+  queue.mapped = static_cast<uint8_t*>(allocation_info.pMappedData);
+
+  return upload_queues_.Create(std::move(queue));
+}
+
+void DestroyUploadQueue(UploadQueue queue_handle) {
+  auto& queue = upload_queues_[queue_handle];
+  auto& device = devices_[queue.device];
+  SubmitUploadBatch(queue);
+  while (RetireOldestUploadBatch(queue, device, true)) {
+  }
+  for (auto& batch : queue.batches) {
+    vkDestroyFence(device.device, batch.fence, nullptr);
+  }
+  vkDestroyCommandPool(device.device, queue.pool, nullptr);
+  vmaDestroyBuffer(device.allocator, queue.staging, queue.allocation);
+  upload_queues_.Destroy(queue_handle);
+}
+
+UploadToken UploadToBuffer(UploadQueue queue_handle, Buffer buffer,
+                           const void* data, uint64_t size, uint64_t offset) {
+  auto& queue = upload_queues_[queue_handle];
+  auto& device = devices_[queue.device];
+
+  VkBufferCopy region = {};
+  VkBuffer staging = StageUpload(queue, device, data, size, region.srcOffset);
+  region.dstOffset = offset;
+  region.size = size;
+
+  UploadBatchVk& batch = RecordingUploadBatch(queue, device);
+  vkCmdCopyBuffer(batch.cmd, staging, buffers_[buffer].buffer, 1, &region);
+  return batch.token;
+}
+
+UploadToken UploadToImage(UploadQueue queue_handle, Image image,
+                          const void* data, uint64_t size, uint32_t num_regions,
+                          const BufferImageCopy* regions) {
+  auto& queue = upload_queues_[queue_handle];
+  auto& device = devices_[queue.device];
+  auto& image_ref = images_[image];
+
+  uint64_t staging_offset;
+  VkBuffer staging = StageUpload(queue, device, data, size, staging_offset);
+  std::vector<VkBufferImageCopy> copies(
+      reinterpret_cast<const VkBufferImageCopy*>(regions),
+      reinterpret_cast<const VkBufferImageCopy*>(regions) + num_regions);
+  for (auto& copy : copies) {
+    copy.bufferOffset += staging_offset;
+  }
+
+  UploadBatchVk& batch = RecordingUploadBatch(queue, device);
+  const VkPipelineStageFlags read_stage =
+      queue.graphics_queue ? VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+                           : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+  RecordTransitionImageLayout(batch.cmd, image_ref.image,
+                              VK_IMAGE_LAYOUT_UNDEFINED,
+                              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+  vkCmdCopyBufferToImage(batch.cmd, staging, image_ref.image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, num_regions,
+                         copies.data());
+  RecordTransitionImageLayout(
+      batch.cmd, image_ref.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, read_stage);
+  return batch.token;
+}
+
+UploadToken FlushUploads(UploadQueue queue_handle) {
+  auto& queue = upload_queues_[queue_handle];
+  SubmitUploadBatch(queue);
+  return queue.next_token - 1;
+}
+
+bool IsUploadComplete(UploadQueue queue_handle, UploadToken token) {
+  auto& queue = upload_queues_[queue_handle];
+  auto& device = devices_[queue.device];
+  while (queue.completed < token &&
+         RetireOldestUploadBatch(queue, device, false)) {
+  }
+  return queue.completed >= token;
+}
+
+void WaitForUpload(UploadQueue queue_handle, UploadToken token) {
+  auto& queue = upload_queues_[queue_handle];
+  auto& device = devices_[queue.device];
+  if (queue.batches[queue.current].token != 0 &&
+      queue.batches[queue.current].token <= token) {
+    SubmitUploadBatch(queue);
+  }
+  while (queue.completed < token &&
+         RetireOldestUploadBatch(queue, device, true)) {
+  }
+}
+
 ImageView CreateImageView(Device device, const ImageViewCreateInfo& info) {
   auto& device_ref = devices_[device];
 
@@ -11,6 +11,8 @@ namespace RenderAPI {
 struct QueueFamilyIndices {
   int graphics = -1;
   int presentation = -1;
+  // Dedicated transfer family if the device has one, graphics otherwise.
+  int transfer = -1;
 
   bool IsComplete() { return (graphics != -1 && presentation != -1); }
 };
@@ -28,6 +30,7 @@ struct DeviceVk {
   VkDevice device;
   VkQueue graphics_queue;
   VkQueue present_queue;
+  VkQueue transfer_queue;
   VmaAllocator allocator;
 };
 
@@ -43,6 +46,7 @@ struct SwapChainVk {
 struct RenderPassVk {
   Device device;
   VkRenderPass pass;
+  RenderPassCompatibility compatibility;
 };
 
 struct GraphicsPipelineVk {
@@ -95,7 +99,54 @@ struct DescriptorSetPoolVk {
 struct ImageVk {
   Device device;
   VkImage image;
+  // Null for images aliased into a heap.
+  VmaAllocation allocation = VK_NULL_HANDLE;
+};
+
+struct MemoryHeapVk {
+  Device device;
+  VmaAllocation allocation;
+  VkDeviceMemory memory;
+  VkDeviceSize offset;
+  VkDeviceSize size;
+  uint32_t memory_type;
+};
+
+struct PipelineCacheVk {
+  Device device;
+  VkPipelineCache cache;
+};
+
+struct UploadBatchVk {
+  VkCommandBuffer cmd = VK_NULL_HANDLE;
+  VkFence fence = VK_NULL_HANDLE;
+  UploadToken token = 0;
+  bool submitted = false;
+  // Ring head once the batch's copies were staged.
+  uint64_t ring_end = 0;
+  // Staging buffers for copies that don't fit in the ring.
+  std::vector<std::pair<VkBuffer, VmaAllocation>> dedicated;
+};
+
+struct UploadQueueVk {
+  Device device;
+  VkCommandPool pool;
+  VkQueue queue;
+  bool graphics_queue;
+
+  // Staging ring, persistently mapped. Head and tail grow monotonically.
+  VkBuffer staging;
   VmaAllocation allocation;
+  uint8_t* mapped;
+  uint64_t size;
+  uint64_t head = 0;
+  uint64_t tail = 0;
+
+  std::vector<UploadBatchVk> batches;
+  uint32_t current = 0;
+  uint32_t oldest = 0;
+  UploadToken next_token = 1;
+  UploadToken completed = 0;
 };
 
 }  // namespace RenderAPI
\ No newline at end of file
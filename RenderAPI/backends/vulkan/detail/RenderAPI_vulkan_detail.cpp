@@ -132,9 +132,22 @@ QueueFamilyIndices FindQueueFamilies(InstanceVk& instance,
       if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
         indices.graphics = i;
       }
+      // Prefer a transfer only family (DMA engine), then anything that
+      // isn't the graphics family.
+      const bool transfer_only =
+          (queueFamily.queueFlags &
+           (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0;
+      if ((queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+          !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+          (indices.transfer == -1 || transfer_only)) {
+        indices.transfer = i;
+      }
     }
     i++;
   }
+  if (indices.transfer == -1) {
+    indices.transfer = indices.graphics;
+  }
   return indices;
 }
 
@@ -219,16 +232,25 @@ VkDevice CreateLogicalDevice(
       VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
   float queuePriority = 1.0f;
-  VkDeviceQueueCreateInfo queueCreateInfo[2] = {};
-  queueCreateInfo[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-  queueCreateInfo[0].queueFamilyIndex = indices.graphics;
-  queueCreateInfo[0].queueCount = 1;
-  queueCreateInfo[0].pQueuePriorities = &queuePriority;
-
-  queueCreateInfo[1].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-  queueCreateInfo[1].queueFamilyIndex = indices.presentation;
-  queueCreateInfo[1].queueCount = 1;
-  queueCreateInfo[1].pQueuePriorities = &queuePriority;
+  const int families[] = {indices.graphics, indices.presentation,
+                          indices.transfer};
+  VkDeviceQueueCreateInfo queueCreateInfo[3] = {};
+  uint32_t queue_count = 0;
+  for (int family : families) {
+    bool duplicate = false;
+    for (uint32_t i = 0; i < queue_count; ++i) {
+      duplicate |= queueCreateInfo[i].queueFamilyIndex == family;
+    }
+    if (duplicate) {
+      continue;
+    }
+    queueCreateInfo[queue_count].sType =
+        VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueCreateInfo[queue_count].queueFamilyIndex = family;
+    queueCreateInfo[queue_count].queueCount = 1;
+    queueCreateInfo[queue_count].pQueuePriorities = &queuePriority;
+    ++queue_count;
+  }
 
   VkPhysicalDeviceDescriptorIndexingFeaturesEXT extended_features = {};
   extended_features.sType =
@@ -242,8 +264,7 @@ VkDevice CreateLogicalDevice(
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
   createInfo.pNext = &extended_features;
   createInfo.pQueueCreateInfos = queueCreateInfo;
-  createInfo.queueCreateInfoCount =
-      (indices.graphics == indices.presentation) ? 1 : 2;
+  createInfo.queueCreateInfoCount = queue_count;
   createInfo.pEnabledFeatures = &deviceFeatures;
   createInfo.enabledExtensionCount =
       static_cast<uint32_t>(required_device_extensions.size());
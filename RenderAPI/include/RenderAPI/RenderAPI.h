@@ -6,6 +6,18 @@
 #include "RenderAPI_pipelines.h"
 #include "RenderAPI_texture.h"
 
+// Threading.
+// Objects can be created, destroyed and looked up from any thread. The objects
+// themselves follow Vulkan's external synchronization rules:
+// - An object must not be destroyed while another thread is using it.
+// - A command buffer, and the command pool it comes from, is recorded by one
+//   thread at a time. Use a pool per recording thread.
+// - Allocating from a descriptor set pool, updating a descriptor set and
+//   writing a mapped buffer need exclusive access to that object.
+// - Calls reaching a device's queues (QueueSubmit, QueuePresent, FlushUploads,
+//   StageCopyDataToBuffer and StageCopyDataToImage) are made from one thread
+//   at a time, an upload queue is used by one thread at a time.
+
 namespace RenderAPI {
 using HandleType = uint64_t;
 static constexpr HandleType kInvalidHandle = 0;
@@ -29,6 +41,9 @@ using Image = HandleType;
 using ImageView = HandleType;
 using Sampler = HandleType;
 using ShaderModule = HandleType;
+using UploadQueue = HandleType;
+using PipelineCache = HandleType;
+using MemoryHeap = HandleType;
 
 struct VertexInputAttribute {
   uint32_t location;
@@ -117,9 +132,22 @@ struct GraphicsPipelineCreateInfo {
   GraphicsPipelineStateInfo states;
 };
 GraphicsPipeline CreateGraphicsPipeline(Device device, RenderPass pass,
-                                        const GraphicsPipelineCreateInfo& info);
+                                        const GraphicsPipelineCreateInfo& info,
+                                        PipelineCache cache = kInvalidHandle);
 void DestroyGraphicsPipeline(GraphicsPipeline pipeline);
 
+// Pipeline cache.
+// Initial data produced by another device or driver is discarded and the cache
+// starts empty, discarded (optional) reports whether that happened.
+PipelineCache CreatePipelineCache(Device device, const void* data = nullptr,
+                                  size_t size = 0, bool* discarded = nullptr);
+void DestroyPipelineCache(PipelineCache cache);
+std::vector<uint8_t> GetPipelineCacheData(PipelineCache cache);
+// Helpers. A missing or unreadable file yields an empty cache.
+PipelineCache LoadPipelineCache(Device device, const char* filename,
+                                bool* discarded = nullptr);
+bool SavePipelineCache(PipelineCache cache, const char* filename);
+
 enum AttachmentDescriptionFlags {
 
 };
@@ -182,6 +210,22 @@ struct RenderPassCreateInfo {
 // Render pass.
 RenderPass CreateRenderPass(Device device, const RenderPassCreateInfo& info);
 void DestroyRenderPass(RenderPass pass);
+// Render passes with the same attachment formats and sample counts, in order,
+// are compatible: a pipeline created for one can be used with the others.
+struct RenderPassCompatibility {
+  struct Attachment {
+    TextureFormat format;
+    SampleCountFlagBits samples;
+  };
+  std::vector<Attachment> attachments;
+  // Of the attachments, passes with the same hash may still be incompatible.
+  uint64_t hash = 0;
+};
+bool operator==(const RenderPassCompatibility& lhs,
+                const RenderPassCompatibility& rhs);
+RenderPassCompatibility GetRenderPassCompatibility(
+    const RenderPassCreateInfo& info);
+RenderPassCompatibility GetRenderPassCompatibility(RenderPass pass);
 
 // Framebuffers.
 struct FramebufferCreateInfo {
@@ -263,26 +307,55 @@ struct ClearValue {
       : depth_stencil(std::move(depth_stencil)) {}
 };
 // Command Buffers.
+enum class SubpassContents {
+  kInline = 0,
+  // The render pass is only recorded to through CmdExecuteCommands.
+  kSecondaryCommandBuffers = 1,
+};
+
 struct BeginRenderPassInfo {
   RenderPass pass;
   Framebuffer framebuffer;
   Rect2D render_area;
   uint32_t clear_values_count = 0;
   const ClearValue* clear_values = nullptr;
+  SubpassContents contents = SubpassContents::kInline;
 
   BeginRenderPassInfo(RenderPass pass, Framebuffer framebuffer,
                       Rect2D render_area, uint32_t clear_values_count = 0,
-                      const ClearValue* clear_values = nullptr)
+                      const ClearValue* clear_values = nullptr,
+                      SubpassContents contents = SubpassContents::kInline)
       : pass(pass),
         framebuffer(framebuffer),
         render_area(render_area),
         clear_values_count(clear_values_count),
-        clear_values(clear_values) {}
+        clear_values(clear_values),
+        contents(contents) {}
+};
+
+enum class CommandBufferLevel {
+  kPrimary = 0,
+  kSecondary = 1,
+};
+
+// Render pass a secondary command buffer is executed in, the framebuffer is
+// optional.
+struct CommandBufferInheritanceInfo {
+  RenderPass pass = kInvalidHandle;
+  uint32_t subpass = 0;
+  Framebuffer framebuffer = kInvalidHandle;
 };
-CommandBuffer CreateCommandBuffer(CommandPool pool);
+
+CommandBuffer CreateCommandBuffer(
+    CommandPool pool, CommandBufferLevel level = CommandBufferLevel::kPrimary);
 void DestroyCommandBuffer(CommandBuffer buffer);
 void CmdBegin(CommandBuffer buffer);
+// Begins a secondary command buffer that continues a render pass.
+void CmdBegin(CommandBuffer buffer,
+              const CommandBufferInheritanceInfo& inheritance);
 void CmdEnd(CommandBuffer buffer);
+void CmdExecuteCommands(CommandBuffer buffer, uint32_t count,
+                        const CommandBuffer* buffers);
 void CmdSetViewport(CommandBuffer buffer, uint32_t first_viewport,
                     uint32_t viewport_count, const Viewport* viewports);
 void CmdSetScissor(CommandBuffer buffer, uint32_t first_scissor, uint32_t count,
@@ -319,6 +392,56 @@ struct BufferCopy {
 void CmdCopyBuffer(CommandBuffer cmd, Buffer src, Buffer dst,
                    uint32_t region_count, const BufferCopy* regions);
 
+// Synchronization.
+namespace PipelineStageFlagBits {
+enum PipelineStageFlagBits {
+  kTopOfPipeBit = 0x00000001,
+  kDrawIndirectBit = 0x00000002,
+  kVertexInputBit = 0x00000004,
+  kVertexShaderBit = 0x00000008,
+  kFragmentShaderBit = 0x00000080,
+  kEarlyFragmentTestsBit = 0x00000100,
+  kLateFragmentTestsBit = 0x00000200,
+  kColorAttachmentOutputBit = 0x00000400,
+  kComputeShaderBit = 0x00000800,
+  kTransferBit = 0x00001000,
+  kBottomOfPipeBit = 0x00002000,
+  kAllGraphicsBit = 0x00008000,
+  kAllCommandsBit = 0x00010000,
+};
+}  // namespace PipelineStageFlagBits
+using PipelineStageFlags = uint32_t;
+
+namespace AccessFlagBits {
+enum AccessFlagBits {
+  kIndirectCommandReadBit = 0x00000001,
+  kIndexReadBit = 0x00000002,
+  kVertexAttributeReadBit = 0x00000004,
+  kUniformReadBit = 0x00000008,
+  kInputAttachmentReadBit = 0x00000010,
+  kShaderReadBit = 0x00000020,
+  kShaderWriteBit = 0x00000040,
+  kColorAttachmentReadBit = 0x00000080,
+  kColorAttachmentWriteBit = 0x00000100,
+  kDepthStencilAttachmentReadBit = 0x00000200,
+  kDepthStencilAttachmentWriteBit = 0x00000400,
+  kTransferReadBit = 0x00000800,
+  kTransferWriteBit = 0x00001000,
+  kMemoryReadBit = 0x00008000,
+  kMemoryWriteBit = 0x00010000,
+};
+}  // namespace AccessFlagBits
+using AccessFlags = uint32_t;
+
+// A global memory barrier, layouts are left to the render passes.
+struct PipelineBarrier {
+  PipelineStageFlags src_stages = 0;
+  PipelineStageFlags dst_stages = 0;
+  AccessFlags src_access = 0;
+  AccessFlags dst_access = 0;
+};
+void CmdPipelineBarrier(CommandBuffer cmd, const PipelineBarrier& barrier);
+
 // Semaphores.
 Semaphore CreateSemaphore(Device);
 void DestroySemaphore(Semaphore);
@@ -399,7 +522,8 @@ void UpdateDescriptorSets(Device device, uint32_t descriptor_write_count,
 struct SubmitInfo {
   const Semaphore* wait_semaphores;
   uint32_t wait_semaphores_count = 0;
-  uint32_t wait_flags;
+  // One stage mask per wait semaphore, null waits at color attachment output.
+  const PipelineStageFlags* wait_stages = nullptr;
   const Semaphore* signal_semaphores;
   uint32_t signal_semaphores_count = 0;
   const CommandBuffer* command_buffers;
@@ -407,6 +531,10 @@ struct SubmitInfo {
 };
 void QueueSubmit(Device device, const SubmitInfo& info,
                  Fence fence = kInvalidHandle);
+// Submits every batch in a single queue submission, the fence is signaled once
+// all of them have completed.
+void QueueSubmit(Device device, const SubmitInfo* infos, uint32_t count,
+                 Fence fence = kInvalidHandle);
 
 struct PresentInfo {
   uint32_t wait_semaphores_count = 0;
@@ -418,6 +546,21 @@ void QueuePresent(SwapChain swapchain, uint32_t image, const PresentInfo& info);
 Image CreateImage(Device device, const ImageCreateInfo& info);
 void DestroyImage(Image image);
 
+// Aliased images are placed at an offset in a heap and don't own their memory.
+// Images sharing memory must not be in use at the same time.
+struct MemoryRequirements {
+  uint64_t size;
+  uint64_t alignment;
+  uint32_t memory_type_bits;
+};
+MemoryRequirements GetImageMemoryRequirements(Device device,
+                                              const ImageCreateInfo& info);
+MemoryHeap CreateMemoryHeap(Device device, uint64_t size,
+                            uint32_t memory_type_bits);
+void DestroyMemoryHeap(MemoryHeap heap);
+Image CreateAliasedImage(Device device, const ImageCreateInfo& info,
+                         MemoryHeap heap, uint64_t offset);
+
 // Shader Modules.
 ShaderModule CreateShaderModule(Device device, const uint32_t* code,
                                 size_t size);
@@ -442,6 +585,27 @@ void StageCopyDataToImage(CommandPool pool, Image image, const void* data,
                           uint64_t size, uint32_t num_regions,
                           const BufferImageCopy* regions);
 
+// Uploads.
+// Copies are staged through a persistent ring buffer and batched into a single
+// submit per flush, on a dedicated transfer queue when the device has one.
+// Uploads are asynchronous: the destination must not be used until the token
+// returned for the copy is complete. Tokens complete in increasing order.
+// Destinations must be created with transfer dst usage.
+using UploadToken = uint64_t;
+constexpr uint64_t kDefaultStagingSize = 64 * 1024 * 1024;
+UploadQueue CreateUploadQueue(Device device,
+                              uint64_t staging_size = kDefaultStagingSize);
+void DestroyUploadQueue(UploadQueue queue);
+UploadToken UploadToBuffer(UploadQueue queue, Buffer buffer, const void* data,
+                           uint64_t size, uint64_t offset = 0);
+UploadToken UploadToImage(UploadQueue queue, Image image, const void* data,
+                          uint64_t size, uint32_t num_regions,
+                          const BufferImageCopy* regions);
+// Submits the pending copies and returns the token of the last copy.
+UploadToken FlushUploads(UploadQueue queue);
+bool IsUploadComplete(UploadQueue queue, UploadToken token);
+void WaitForUpload(UploadQueue queue, UploadToken token);
+
 struct ImageViewCreateInfo {
   Image image;
   ImageViewType type;
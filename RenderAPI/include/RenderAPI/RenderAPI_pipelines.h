@@ -292,7 +292,7 @@ struct ColorBlendState {
   bool logic_op_enable = false;
   LogicOp logic_op = LogicOp::kCopy;
   std::vector<ColorBlendAttachmentState> attachments;
-  float blend_constants[4];
+  float blend_constants[4] = {};
 };
 
 struct DynamicStateInfo {
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <RenderAPI/RenderAPI.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace RenderUtils {
+struct LayoutCacheStats {
+  uint64_t set_layout_hits = 0;
+  uint64_t set_layout_misses = 0;
+  uint64_t pipeline_layout_hits = 0;
+  uint64_t pipeline_layout_misses = 0;
+};
+
+// Process-wide cache of descriptor set layouts by binding descriptions and of
+// pipeline layouts by set layouts and push constant ranges. Identical layouts
+// share a handle, so sets bound with one pipeline layout stay valid for every
+// pipeline using it. Objects are destroyed with their last reference.
+// Thread-safe.
+class LayoutCache {
+ public:
+  static LayoutCache& Get();
+
+  RenderAPI::DescriptorSetLayout AcquireSetLayout(
+      RenderAPI::Device device,
+      const RenderAPI::DescriptorSetLayoutCreateInfo& info);
+  void ReleaseSetLayout(RenderAPI::DescriptorSetLayout layout);
+
+  // The set layouts of the info are compared by handle.
+  RenderAPI::PipelineLayout AcquirePipelineLayout(
+      RenderAPI::Device device,
+      const RenderAPI::PipelineLayoutCreateInfo& info);
+  void ReleasePipelineLayout(RenderAPI::PipelineLayout layout);
+
+  LayoutCacheStats GetStats() const;
+
+ private:
+  struct Caches;
+  std::unique_ptr<Caches> caches_;
+  mutable std::mutex mutex_;
+  LayoutCacheStats stats_;
+
+  LayoutCache();
+  ~LayoutCache();
+};
+}  // namespace RenderUtils
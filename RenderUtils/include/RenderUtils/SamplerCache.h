@@ -0,0 +1,37 @@
+#pragma once
+
+#include <RenderAPI/RenderAPI.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace RenderUtils {
+struct SamplerCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  // Samplers alive, implementations cap them (maxSamplerAllocationCount).
+  uint64_t live = 0;
+};
+
+// Process-wide cache of samplers by create info. Equal infos share a sampler,
+// which is destroyed with its last reference. Thread-safe.
+class SamplerCache {
+ public:
+  static SamplerCache& Get();
+
+  RenderAPI::Sampler Acquire(RenderAPI::Device device,
+                             const RenderAPI::SamplerCreateInfo& info);
+  void Release(RenderAPI::Sampler sampler);
+
+  SamplerCacheStats GetStats() const;
+
+ private:
+  struct Cache;
+  std::unique_ptr<Cache> cache_;
+  mutable std::mutex mutex_;
+  SamplerCacheStats stats_;
+
+  SamplerCache();
+  ~SamplerCache();
+};
+}  // namespace RenderUtils
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <RenderAPI/RenderAPI.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace RenderUtils {
+struct ShaderCacheStats {
+  uint64_t module_hits = 0;
+  uint64_t module_misses = 0;
+  uint64_t pipeline_hits = 0;
+  uint64_t pipeline_misses = 0;
+};
+
+// Process-wide cache of shader modules and graphics pipelines by content.
+// Identical SPIR-V shares a module, and pipelines with the same create info
+// for compatible render passes are shared. Objects are destroyed with their
+// last reference. Thread-safe.
+class ShaderCache {
+ public:
+  static ShaderCache& Get();
+
+  RenderAPI::ShaderModule AcquireModule(RenderAPI::Device device,
+                                        const uint32_t* code, size_t size);
+  void ReleaseModule(RenderAPI::ShaderModule module);
+
+  // The shaders of the info must be modules, the layout is compared by handle.
+  // Pipelines compile without holding the cache's lock, threads acquiring one
+  // being compiled wait for it.
+  RenderAPI::GraphicsPipeline AcquirePipeline(
+      RenderAPI::Device device, RenderAPI::RenderPass pass,
+      const RenderAPI::GraphicsPipelineCreateInfo& info,
+      RenderAPI::PipelineCache cache = RenderAPI::kInvalidHandle);
+  void ReleasePipeline(RenderAPI::GraphicsPipeline pipeline);
+
+  ShaderCacheStats GetStats() const;
+
+ private:
+  struct Caches;
+  std::unique_ptr<Caches> caches_;
+  mutable std::mutex mutex_;
+  ShaderCacheStats stats_;
+
+  ShaderCache();
+  ~ShaderCache();
+};
+}  // namespace RenderUtils
@@ -28,15 +28,21 @@ class TextureManager {
   void AddRef(RenderAPI::ImageView texture);
   void Release(RenderAPI::ImageView texture);
 
+  // Texture data is uploaded asynchronously through this queue. Flush submits
+  // the pending uploads and returns the token to wait on before sampling.
+  RenderAPI::UploadQueue GetUploadQueue() const;
+  RenderAPI::UploadToken Flush();
+
   static TextureManager* Get();
 
  private:
   RenderAPI::Device device_;
-  RenderAPI::CommandPool pool_;
+  RenderAPI::UploadQueue uploads_;
 
   struct CachedTexture {
     uint32_t refs = 1;
     RenderAPI::Image image;
+    RenderAPI::UploadToken upload = 0;
     TextureCreateInfo info;
   };
   std::unordered_map<RenderAPI::ImageView, CachedTexture> cache_;
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <RenderAPI/RenderAPI.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace RenderUtils {
+// Persistently mapped uniform buffer split into one region per buffered frame.
+// Data pushed during a frame is addressed by its offset into the buffer, which
+// is meant to be passed as a dynamic offset to CmdBindDescriptorSets so the
+// descriptor set pointing at the ring never needs to be rewritten.
+class UniformRing {
+ public:
+  // frame_count must cover the frames the GPU may still be reading, e.g. the
+  // render graph's frames in flight.
+  static UniformRing* Create(RenderAPI::Device device, size_t frame_size,
+                             uint32_t frame_count);
+  static void Destroy(UniformRing* ring);
+
+  // Moves to the next frame's region. Data pushed frame_count frames ago is
+  // overwritten from here on. Must not run concurrently with Push().
+  void NextFrame();
+
+  // Copies the data into the current frame's region and returns its offset.
+  // Thread-safe, passes recording on different threads may push at once.
+  uint32_t Push(const void* data, size_t size);
+  template <typename T>
+  uint32_t Push(const T& data);
+
+  RenderAPI::Buffer GetBuffer() const;
+
+ private:
+  // Largest minUniformBufferOffsetAlignment allowed by the spec.
+  static constexpr size_t kAlignment = 256;
+
+  RenderAPI::Buffer buffer_ = RenderAPI::kInvalidHandle;
+  uint8_t* data_ = nullptr;
+  size_t frame_size_ = 0;
+  uint32_t frame_count_ = 0;
+  uint32_t frame_ = 0;
+  std::atomic<size_t> offset_ = 0;
+
+  UniformRing() = default;
+};
+
+template <typename T>
+uint32_t UniformRing::Push(const T& data) {
+  return Push(reinterpret_cast<const void*>(&data), sizeof(T));
+}
+}  // namespace RenderUtils
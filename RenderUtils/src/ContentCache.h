@@ -0,0 +1,146 @@
+#pragma once
+
+#include <RenderAPI/RenderAPI.h>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace RenderUtils {
+// Serializes the fields of a create info into a key, so objects are compared
+// byte for byte without padding.
+class ContentKey {
+ public:
+  template <typename T>
+  ContentKey& Add(const T& value) {
+    static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>,
+                  "Add the fields of structs one by one!");
+    const size_t offset = data_.size();
+    data_.resize(offset + sizeof(T));
+    memcpy(data_.data() + offset, &value, sizeof(T));
+    return *this;
+  }
+
+  ContentKey& AddBytes(const void* data, size_t size) {
+    Add(size);
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    data_.insert(data_.end(), bytes, bytes + size);
+    return *this;
+  }
+
+  uint64_t Hash() const {
+    // FNV-1a.
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (uint8_t byte : data_) {
+      hash = (hash ^ byte) * 0x100000001b3ull;
+    }
+    return hash;
+  }
+
+  bool operator==(const ContentKey& other) const {
+    return data_ == other.data_;
+  }
+
+ private:
+  std::vector<uint8_t> data_;
+};
+
+// Reference counted objects of a device shared by content. Not thread-safe,
+// the caches using it lock around it. Objects slow to create can be created
+// outside the lock with Find and Insert instead of Acquire.
+template <typename Handle>
+class ContentCache {
+ public:
+  // Returns the object with the same key, or the one create() returns. hit is
+  // set when the object already existed.
+  template <typename CreateFn>
+  Handle Acquire(RenderAPI::Device device, ContentKey key, CreateFn&& create,
+                 bool* hit = nullptr) {
+    Handle handle;
+    const bool found = Find(device, key, &handle);
+    if (hit) {
+      *hit = found;
+    }
+    if (!found) {
+      handle = create();
+      Insert(device, std::move(key), handle);
+    }
+    return handle;
+  }
+
+  // Adds a reference to the object with the same key, if there is one.
+  bool Find(RenderAPI::Device device, ContentKey key, Handle* handle) {
+    key.Add(device);
+    const auto bucket = entries_.find(key.Hash());
+    if (bucket == entries_.end()) {
+      return false;
+    }
+    for (auto& it : bucket->second) {
+      if (it.key == key) {
+        ++it.refs;
+        *handle = it.handle;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Adds an object created for a key that isn't cached yet, with refs
+  // references.
+  void Insert(RenderAPI::Device device, ContentKey key, Handle handle,
+              uint32_t refs = 1) {
+    key.Add(device);
+    const uint64_t hash = key.Hash();
+    Entry entry;
+    entry.key = std::move(key);
+    entry.handle = handle;
+    entry.device = device;
+    entry.refs = refs;
+    entries_[hash].emplace_back(std::move(entry));
+    hashes_[handle] = hash;
+  }
+
+  // Returns true when the last reference is gone and the object must be
+  // destroyed, its device is returned for that.
+  bool Release(Handle handle, RenderAPI::Device* device = nullptr) {
+    const auto& hash_it = hashes_.find(handle);
+    assert(hash_it != hashes_.end() && "Unknown cached object!");
+    std::vector<Entry>& bucket = entries_[hash_it->second];
+    for (size_t i = 0; i < bucket.size(); ++i) {
+      if (bucket[i].handle != handle) {
+        continue;
+      }
+      if (--bucket[i].refs > 0) {
+        return false;
+      }
+      if (device) {
+        *device = bucket[i].device;
+      }
+      bucket[i] = std::move(bucket.back());
+      bucket.pop_back();
+      if (bucket.empty()) {
+        entries_.erase(hash_it->second);
+      }
+      hashes_.erase(hash_it);
+      return true;
+    }
+    assert(false && "Unknown cached object!");
+    return false;
+  }
+
+  size_t GetSize() const { return hashes_.size(); }
+
+ private:
+  struct Entry {
+    ContentKey key;
+    Handle handle;
+    RenderAPI::Device device;
+    uint32_t refs = 1;
+  };
+  std::unordered_map<uint64_t, std::vector<Entry>> entries_;
+  std::unordered_map<Handle, uint64_t> hashes_;
+};
+}  // namespace RenderUtils
@@ -0,0 +1,79 @@
+#include <RenderUtils/LayoutCache.h>
+
+#include "ContentCache.h"
+
+namespace RenderUtils {
+struct LayoutCache::Caches {
+  ContentCache<RenderAPI::DescriptorSetLayout> set_layouts;
+  ContentCache<RenderAPI::PipelineLayout> pipeline_layouts;
+};
+
+LayoutCache::LayoutCache() : caches_(std::make_unique<Caches>()) {}
+
+LayoutCache::~LayoutCache() = default;
+
+LayoutCache& LayoutCache::Get() {
+  static LayoutCache cache;
+  return cache;
+}
+
+RenderAPI::DescriptorSetLayout LayoutCache::AcquireSetLayout(
+    RenderAPI::Device device,
+    const RenderAPI::DescriptorSetLayoutCreateInfo& info) {
+  ContentKey key;
+  key.Add(info.bindings.size());
+  for (const auto& it : info.bindings) {
+    key.Add(it.type).Add(it.count).Add(it.stages).Add(it.flags);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool hit = false;
+  RenderAPI::DescriptorSetLayout layout = caches_->set_layouts.Acquire(
+      device, std::move(key),
+      [&]() { return RenderAPI::CreateDescriptorSetLayout(device, info); },
+      &hit);
+  ++(hit ? stats_.set_layout_hits : stats_.set_layout_misses);
+  return layout;
+}
+
+void LayoutCache::ReleaseSetLayout(RenderAPI::DescriptorSetLayout layout) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (caches_->set_layouts.Release(layout)) {
+    RenderAPI::DestroyDescriptorSetLayout(layout);
+  }
+}
+
+RenderAPI::PipelineLayout LayoutCache::AcquirePipelineLayout(
+    RenderAPI::Device device, const RenderAPI::PipelineLayoutCreateInfo& info) {
+  ContentKey key;
+  key.Add(info.layouts.size());
+  for (auto it : info.layouts) {
+    key.Add(it);
+  }
+  key.Add(info.push_constants.size());
+  for (const auto& it : info.push_constants) {
+    key.Add(it.flags).Add(it.offset).Add(it.size);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool hit = false;
+  RenderAPI::PipelineLayout layout = caches_->pipeline_layouts.Acquire(
+      device, std::move(key),
+      [&]() { return RenderAPI::CreatePipelineLayout(device, info); }, &hit);
+  ++(hit ? stats_.pipeline_layout_hits : stats_.pipeline_layout_misses);
+  return layout;
+}
+
+void LayoutCache::ReleasePipelineLayout(RenderAPI::PipelineLayout layout) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  RenderAPI::Device device;
+  if (caches_->pipeline_layouts.Release(layout, &device)) {
+    RenderAPI::DestroyPipelineLayout(device, layout);
+  }
+}
+
+LayoutCacheStats LayoutCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+}  // namespace RenderUtils
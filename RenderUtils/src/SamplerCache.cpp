@@ -0,0 +1,56 @@
+#include <RenderUtils/SamplerCache.h>
+
+#include "ContentCache.h"
+
+namespace RenderUtils {
+struct SamplerCache::Cache {
+  ContentCache<RenderAPI::Sampler> samplers;
+};
+
+SamplerCache::SamplerCache() : cache_(std::make_unique<Cache>()) {}
+
+SamplerCache::~SamplerCache() = default;
+
+SamplerCache& SamplerCache::Get() {
+  static SamplerCache cache;
+  return cache;
+}
+
+RenderAPI::Sampler SamplerCache::Acquire(
+    RenderAPI::Device device, const RenderAPI::SamplerCreateInfo& info) {
+  ContentKey key;
+  key.Add(info.min_filter)
+      .Add(info.mag_filter)
+      .Add(info.mipmap_mode)
+      .Add(info.address_mode_u)
+      .Add(info.address_mode_v)
+      .Add(info.address_mode_w)
+      .Add(info.min_lod)
+      .Add(info.max_lod)
+      .Add(info.compare_enable)
+      .Add(info.compare_op);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool hit = false;
+  RenderAPI::Sampler sampler = cache_->samplers.Acquire(
+      device, std::move(key),
+      [&]() { return RenderAPI::CreateSampler(device, info); }, &hit);
+  ++(hit ? stats_.hits : stats_.misses);
+  stats_.live = cache_->samplers.GetSize();
+  return sampler;
+}
+
+void SamplerCache::Release(RenderAPI::Sampler sampler) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  RenderAPI::Device device;
+  if (cache_->samplers.Release(sampler, &device)) {
+    RenderAPI::DestroySampler(device, sampler);
+  }
+  stats_.live = cache_->samplers.GetSize();
+}
+
+SamplerCacheStats SamplerCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+}  // namespace RenderUtils
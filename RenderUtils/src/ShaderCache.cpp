@@ -0,0 +1,241 @@
+#include <RenderUtils/ShaderCache.h>
+
+#include <algorithm>
+#include <future>
+#include <vector>
+
+#include "ContentCache.h"
+
+namespace RenderUtils {
+namespace {
+void AddShader(ContentKey& key, const RenderAPI::ShaderCreateInfo& shader) {
+  assert(shader.module != RenderAPI::kInvalidHandle &&
+         "Cached pipelines must use shader modules!");
+  key.Add(shader.module);
+  const RenderAPI::SpecializationInfo* specialization = shader.specialization;
+  if (!specialization) {
+    key.Add(0u);
+    return;
+  }
+  key.Add(specialization->map_entry_count);
+  for (uint32_t i = 0; i < specialization->map_entry_count; ++i) {
+    key.Add(specialization->map_entries[i].constantID)
+        .Add(specialization->map_entries[i].offset)
+        .Add(specialization->map_entries[i].size);
+  }
+  key.AddBytes(specialization->data, specialization->data_size);
+}
+
+void AddStencilOp(ContentKey& key, const RenderAPI::StencilOpState& state) {
+  key.Add(state.fail_op)
+      .Add(state.pass_op)
+      .Add(state.depth_fail_op)
+      .Add(state.compare_op)
+      .Add(state.compare_mask)
+      .Add(state.write_mask)
+      .Add(state.reference);
+}
+
+ContentKey PipelineKey(RenderAPI::RenderPass pass,
+                       const RenderAPI::GraphicsPipelineCreateInfo& info) {
+  ContentKey key;
+  const RenderAPI::RenderPassCompatibility compatibility =
+      RenderAPI::GetRenderPassCompatibility(pass);
+  key.Add(compatibility.attachments.size());
+  for (const auto& it : compatibility.attachments) {
+    key.Add(it.format).Add(it.samples);
+  }
+  AddShader(key, info.vertex);
+  AddShader(key, info.fragment);
+  key.Add(info.layout);
+
+  key.Add(info.vertex_input.attributes.size());
+  for (const auto& it : info.vertex_input.attributes) {
+    key.Add(it.location).Add(it.binding).Add(it.format).Add(it.offset);
+  }
+  key.Add(info.vertex_input.bindings.size());
+  for (const auto& it : info.vertex_input.bindings) {
+    key.Add(it.binding).Add(it.stride).Add(it.input_rate);
+  }
+
+  const RenderAPI::GraphicsPipelineStateInfo& states = info.states;
+  key.Add(states.primitive.topology).Add(states.primitive.restart_enable);
+  key.Add(states.viewport.viewports.size());
+  for (const auto& it : states.viewport.viewports) {
+    key.Add(it.x)
+        .Add(it.y)
+        .Add(it.width)
+        .Add(it.height)
+        .Add(it.min_depth)
+        .Add(it.max_depth);
+  }
+  key.Add(states.viewport.scissors.size());
+  for (const auto& it : states.viewport.scissors) {
+    key.Add(it.offset.x)
+        .Add(it.offset.y)
+        .Add(it.extent.width)
+        .Add(it.extent.height);
+  }
+
+  const RenderAPI::RasterizationState& rasterization = states.rasterization;
+  key.Add(rasterization.depth_clamp_enable)
+      .Add(rasterization.rasterizer_discard_enable)
+      .Add(rasterization.polygon_mode)
+      .Add(rasterization.cull_mode)
+      .Add(rasterization.front_face)
+      .Add(rasterization.depth_bias_enable)
+      .Add(rasterization.depth_bias_constant_factor)
+      .Add(rasterization.depth_bias_clamp)
+      .Add(rasterization.depth_bias_slope_factor)
+      .Add(rasterization.line_width);
+
+  const RenderAPI::DepthStencilState& depth_stencil = states.depth_stencil;
+  key.Add(depth_stencil.depth_test_enable)
+      .Add(depth_stencil.depth_write_enable)
+      .Add(depth_stencil.depth_compare_op)
+      .Add(depth_stencil.depth_bounds_test_enable)
+      .Add(depth_stencil.stencil_test_enable)
+      .Add(depth_stencil.min_depth_bounds)
+      .Add(depth_stencil.max_depth_bounds);
+  AddStencilOp(key, depth_stencil.front);
+  AddStencilOp(key, depth_stencil.back);
+
+  key.Add(states.blend.logic_op_enable).Add(states.blend.logic_op);
+  key.Add(states.blend.attachments.size());
+  for (const auto& it : states.blend.attachments) {
+    key.Add(it.blend_enable)
+        .Add(it.src_color_blend_factor)
+        .Add(it.dst_color_blend_factor)
+        .Add(it.color_blend_op)
+        .Add(it.src_alpha_blend_factor)
+        .Add(it.dst_alpha_blend_factor)
+        .Add(it.alpha_blend_op)
+        .Add(it.color_write_mask);
+  }
+  for (float constant : states.blend.blend_constants) {
+    key.Add(constant);
+  }
+
+  key.Add(states.dynamic_states.states.size());
+  for (auto it : states.dynamic_states.states) {
+    key.Add(it);
+  }
+  return key;
+}
+}  // namespace
+
+struct ShaderCache::Caches {
+  ContentCache<RenderAPI::ShaderModule> modules;
+  ContentCache<RenderAPI::GraphicsPipeline> pipelines;
+
+  // Pipelines being compiled outside the lock. Threads acquiring the same one
+  // wait for it instead of compiling it again, the compiling thread adds a
+  // reference for each of them.
+  struct PendingPipeline {
+    ContentKey key;
+    RenderAPI::Device device;
+    std::shared_future<RenderAPI::GraphicsPipeline> pipeline;
+    uint32_t waiters = 0;
+  };
+  std::vector<PendingPipeline> pending_pipelines;
+  std::vector<PendingPipeline>::iterator FindPending(RenderAPI::Device device,
+                                                    const ContentKey& key) {
+    return std::find_if(pending_pipelines.begin(), pending_pipelines.end(),
+                        [&](const PendingPipeline& it) {
+                          return it.device == device && it.key == key;
+                        });
+  }
+};
+
+ShaderCache::ShaderCache() : caches_(std::make_unique<Caches>()) {}
+
+ShaderCache::~ShaderCache() = default;
+
+ShaderCache& ShaderCache::Get() {
+  static ShaderCache cache;
+  return cache;
+}
+
+RenderAPI::ShaderModule ShaderCache::AcquireModule(RenderAPI::Device device,
+                                                   const uint32_t* code,
+                                                   size_t size) {
+  ContentKey key;
+  key.AddBytes(code, size);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool hit = false;
+  RenderAPI::ShaderModule module = caches_->modules.Acquire(
+      device, std::move(key),
+      [&]() { return RenderAPI::CreateShaderModule(device, code, size); },
+      &hit);
+  ++(hit ? stats_.module_hits : stats_.module_misses);
+  return module;
+}
+
+void ShaderCache::ReleaseModule(RenderAPI::ShaderModule module) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  RenderAPI::Device device;
+  if (caches_->modules.Release(module, &device)) {
+    RenderAPI::DestroyShaderModule(device, module);
+  }
+}
+
+RenderAPI::GraphicsPipeline ShaderCache::AcquirePipeline(
+    RenderAPI::Device device, RenderAPI::RenderPass pass,
+    const RenderAPI::GraphicsPipelineCreateInfo& info,
+    RenderAPI::PipelineCache cache) {
+  ContentKey key = PipelineKey(pass, info);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  RenderAPI::GraphicsPipeline pipeline;
+  if (caches_->pipelines.Find(device, key, &pipeline)) {
+    ++stats_.pipeline_hits;
+    return pipeline;
+  }
+  auto pending = caches_->FindPending(device, key);
+  if (pending != caches_->pending_pipelines.end()) {
+    ++stats_.pipeline_hits;
+    ++pending->waiters;
+    std::shared_future<RenderAPI::GraphicsPipeline> future = pending->pipeline;
+    lock.unlock();
+    return future.get();
+  }
+  ++stats_.pipeline_misses;
+  std::promise<RenderAPI::GraphicsPipeline> promise;
+  caches_->pending_pipelines.push_back(
+      {key, device, promise.get_future().share()});
+  lock.unlock();
+
+  // Compiling is slow, other pipelines are acquired meanwhile.
+  try {
+    pipeline = RenderAPI::CreateGraphicsPipeline(device, pass, info, cache);
+  } catch (...) {
+    lock.lock();
+    caches_->pending_pipelines.erase(caches_->FindPending(device, key));
+    lock.unlock();
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+
+  lock.lock();
+  pending = caches_->FindPending(device, key);
+  caches_->pipelines.Insert(device, std::move(key), pipeline,
+                            1 + pending->waiters);
+  caches_->pending_pipelines.erase(pending);
+  lock.unlock();
+  promise.set_value(pipeline);
+  return pipeline;
+}
+
+void ShaderCache::ReleasePipeline(RenderAPI::GraphicsPipeline pipeline) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (caches_->pipelines.Release(pipeline)) {
+    RenderAPI::DestroyGraphicsPipeline(pipeline);
+  }
+}
+
+ShaderCacheStats ShaderCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+}  // namespace RenderUtils
@@ -7,9 +7,7 @@ namespace {
 static TextureManager* g_texture_manager = nullptr;
 }  // namespace
 TextureManager::TextureManager(RenderAPI::Device device) : device_(device) {
-  pool_ = RenderAPI::CreateCommandPool(
-      device_, RenderAPI::CommandPoolCreateFlag::kTransient |
-                   RenderAPI::CommandPoolCreateFlag::kResetCommand);
+  uploads_ = RenderAPI::CreateUploadQueue(device_);
 
   if (!g_texture_manager) {
     g_texture_manager = this;
@@ -21,7 +19,7 @@ TextureManager::~TextureManager() {
     RenderAPI::DestroyImageView(device_, it.first);
     RenderAPI::DestroyImage(it.second.image);
   }
-  RenderAPI::DestroyCommandPool(pool_);
+  RenderAPI::DestroyUploadQueue(uploads_);
 
   if (g_texture_manager == this) {
     g_texture_manager = nullptr;
@@ -52,15 +50,17 @@ RenderAPI::ImageView TextureManager::Create(
   RenderAPI::Image image = RenderAPI::CreateImage(device_, image_info);
 
   // Copy data.
+  RenderAPI::UploadToken upload = 0;
   if (data) {
     assert(size);
     if (num_regions == 0) {
       RenderAPI::BufferImageCopy region(0, 0, 0, info.extent.width,
                                         info.extent.height, info.extent.depth);
-      RenderAPI::StageCopyDataToImage(pool_, image, data, size, 1, &region);
+      upload =
+          RenderAPI::UploadToImage(uploads_, image, data, size, 1, &region);
     } else {
-      RenderAPI::StageCopyDataToImage(pool_, image, data, size, num_regions,
-                                      regions);
+      upload = RenderAPI::UploadToImage(uploads_, image, data, size,
+                                        num_regions, regions);
     }
   }
 
@@ -79,6 +79,7 @@ RenderAPI::ImageView TextureManager::Create(
 
   auto& cached = cache_[view];
   cached.image = image;
+  cached.upload = upload;
   cached.info = std::move(info);
   cached.refs = 1;
 
@@ -94,11 +95,20 @@ void TextureManager::Release(RenderAPI::ImageView texture) {
   auto& it = cache_.find(texture);
   assert(it != cache_.end());
   if (--it->second.refs == 0) {
+    RenderAPI::WaitForUpload(uploads_, it->second.upload);
     RenderAPI::DestroyImageView(device_, texture);
     RenderAPI::DestroyImage(it->second.image);
     cache_.erase(it);
   }
 }
 
+RenderAPI::UploadQueue TextureManager::GetUploadQueue() const {
+  return uploads_;
+}
+
+RenderAPI::UploadToken TextureManager::Flush() {
+  return RenderAPI::FlushUploads(uploads_);
+}
+
 TextureManager* TextureManager::Get() { return g_texture_manager; }
 }  // namespace RenderUtils
\ No newline at end of file
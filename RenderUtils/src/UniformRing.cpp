@@ -0,0 +1,54 @@
+#include <RenderUtils/UniformRing.h>
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace RenderUtils {
+namespace {
+size_t Align(size_t value, size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+}  // namespace
+
+UniformRing* UniformRing::Create(RenderAPI::Device device, size_t frame_size,
+                                 uint32_t frame_count) {
+  assert(frame_count > 0 && "A ring needs at least one frame!");
+  UniformRing* ring = new UniformRing();
+  ring->frame_size_ = Align(frame_size, kAlignment);
+  ring->frame_count_ = frame_count;
+  ring->buffer_ = RenderAPI::CreateBuffer(
+      device, RenderAPI::BufferUsageFlagBits::kUniformBuffer,
+      ring->frame_size_ * frame_count, RenderAPI::MemoryUsage::kCpuToGpu);
+  ring->data_ = reinterpret_cast<uint8_t*>(RenderAPI::MapBuffer(ring->buffer_));
+  return ring;
+}
+
+void UniformRing::Destroy(UniformRing* ring) {
+  if (ring->buffer_ != RenderAPI::kInvalidHandle) {
+    RenderAPI::UnmapBuffer(ring->buffer_);
+    RenderAPI::DestroyBuffer(ring->buffer_);
+  }
+  delete ring;
+}
+
+void UniformRing::NextFrame() {
+  frame_ = (frame_ + 1) % frame_count_;
+  offset_ = 0;
+}
+
+uint32_t UniformRing::Push(const void* data, size_t size) {
+  const size_t aligned_size = Align(size, kAlignment);
+  const size_t frame_offset =
+      offset_.fetch_add(aligned_size, std::memory_order_relaxed);
+  if (frame_offset + aligned_size > frame_size_) {
+    throw std::runtime_error("uniform ring is out of space for this frame!");
+  }
+  const size_t offset = frame_ * frame_size_ + frame_offset;
+  memcpy(data_ + offset, data, size);
+  return static_cast<uint32_t>(offset);
+}
+
+RenderAPI::Buffer UniformRing::GetBuffer() const { return buffer_; }
+
+}  // namespace RenderUtils
@@ -6,6 +6,10 @@
 #include <Renderer/MaterialParams.h>
 #include <cstdint>
 
+namespace RenderUtils {
+class UniformRing;
+}  // namespace RenderUtils
+
 constexpr uint32_t kOffsetNext = -1;
 
 enum class VertexAttribute {
@@ -44,7 +48,11 @@ class Material {
   MaterialInstance* CreateInstance();
   MaterialParams* CreateParams(uint32_t set) const;
 
+  // Compatible render passes share a pipeline, see
+  // RenderAPI::GetRenderPassCompatibility.
   RenderAPI::GraphicsPipeline GetPipeline(RenderAPI::RenderPass pass);
+  // Materials declaring the same descriptors and push constants share a
+  // layout, so sets bound with it stay bound across them.
   RenderAPI::PipelineLayout GetPipelineLayout();
 
  public:
@@ -84,6 +92,11 @@ class Material {
                      RenderAPI::ShaderStageFlags stages, size_t size,
                      const void* default_data = nullptr,
                      RenderAPI::DescriptorBindingFlags flags = 0);
+    // Per-draw data written into |ring| with MaterialInstance::SetDynamicParam
+    // and bound with the instance's dynamic offsets.
+    Builder& DynamicUniform(uint32_t set, uint32_t binding,
+                            RenderAPI::ShaderStageFlags stages, size_t size,
+                            RenderUtils::UniformRing* ring);
     Builder& Texture(uint32_t set, uint32_t binding,
                      RenderAPI::ShaderStageFlags stages,
                      const char* sampler = nullptr,
@@ -92,6 +105,8 @@ class Material {
                                     DescriptorFrequency frequency);
     Builder& Sampler(const char* name, RenderAPI::SamplerCreateInfo info =
                                            RenderAPI::SamplerCreateInfo());
+    // Optional, the cache must outlive the material.
+    Builder& PipelineCache(RenderAPI::PipelineCache cache);
 
     Material* Build();
 
@@ -12,13 +12,27 @@ class MaterialInstance {
   template <typename T>
   void SetParam(uint32_t set, uint32_t binding, const T& data);
 
+  // Writes the data into the material's uniform ring. Takes effect through
+  // DynamicOffsets, no Commit is needed.
+  void SetDynamicParam(uint32_t set, uint32_t binding, const void* data);
+  template <typename T>
+  void SetDynamicParam(uint32_t set, uint32_t binding, const T& data);
+
   void Commit();
 
   const RenderAPI::DescriptorSet* DescriptorSet(uint32_t set) const;
+  const uint32_t* DynamicOffsets(uint32_t set) const;
+  uint32_t DynamicOffsetsCount(uint32_t set) const;
   Material* GetMaterial();
 };
 
 template <typename T>
 void MaterialInstance::SetParam(uint32_t set, uint32_t binding, const T& data) {
   SetParam(set, binding, reinterpret_cast<const void*>(&data));
+}
+
+template <typename T>
+void MaterialInstance::SetDynamicParam(uint32_t set, uint32_t binding,
+                                       const T& data) {
+  SetDynamicParam(set, binding, reinterpret_cast<const void*>(&data));
 }
\ No newline at end of file
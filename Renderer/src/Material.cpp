@@ -1,5 +1,8 @@
 #include "detail/Material.h"
 
+#include <RenderUtils/LayoutCache.h>
+#include <RenderUtils/SamplerCache.h>
+#include <RenderUtils/ShaderCache.h>
 #include <cassert>
 #include <iostream>
 #include <memory>
@@ -28,6 +31,7 @@ struct TextureInfo {
 
 struct Material::BuilderDetails {
   RenderAPI::Device device;
+  RenderAPI::PipelineCache pipeline_cache = RenderAPI::kInvalidHandle;
   Shading shading = Shading::kLit;
   BlendMode blending = BlendMode::kOpaque;
   RenderAPI::GraphicsPipelineCreateInfo info;
@@ -37,6 +41,7 @@ struct Material::BuilderDetails {
   std::vector<VertexAttribute> attributes;
   std::unordered_map<std::string, SamplerInfo> samplers;
   uint32_t num_uniform_buffers = 0;
+  uint32_t num_dynamic_uniform_buffers = 0;
 
   std::vector<uint8_t> frag_specialization_data;
   std::vector<uint8_t> vert_specialization_data;
@@ -182,6 +187,30 @@ Material::Builder& Material::Builder::Uniform(
   return *this;
 }
 
+Material::Builder& Material::Builder::DynamicUniform(
+    uint32_t set, uint32_t binding, RenderAPI::ShaderStageFlags stages,
+    size_t size, RenderUtils::UniformRing* ring) {
+  assert(ring);
+  ++impl_->num_dynamic_uniform_buffers;
+  if (impl_->descriptors.size() <= set) {
+    impl_->descriptors.resize(set + 1);
+  }
+  auto& bindings = impl_->descriptors[set].bindings;
+
+  DescriptorData uniform;
+  uniform.type = RenderAPI::DescriptorType::kUniformBufferDynamic;
+  uniform.uniform.size = size;
+  uniform.stages = stages;
+  uniform.ring = ring;
+
+  if (bindings.size() <= binding) {
+    bindings.resize(binding + 1);
+  }
+  bindings[binding] = std::move(uniform);
+
+  return *this;
+}
+
 Material::Builder& Material::Builder::Texture(
     uint32_t set, uint32_t binding, RenderAPI::ShaderStageFlags stages,
     const char* sampler, RenderAPI::DescriptorBindingFlags flags) {
@@ -216,13 +245,21 @@ Material::Builder& Material::Builder::Sampler(
   return *this;
 }
 
+Material::Builder& Material::Builder::PipelineCache(
+    RenderAPI::PipelineCache cache) {
+  impl_->pipeline_cache = cache;
+  return *this;
+}
+
 Material* Material::Builder::Build() {
   assert(impl_->info.vertex.code);
   assert(impl_->info.fragment.code);
 
-  impl_->info.fragment.module = RenderAPI::CreateShaderModule(
+  // Materials built from the same code share the modules.
+  RenderUtils::ShaderCache& shaders = RenderUtils::ShaderCache::Get();
+  impl_->info.fragment.module = shaders.AcquireModule(
       impl_->device, impl_->info.fragment.code, impl_->info.fragment.code_size);
-  impl_->info.vertex.module = RenderAPI::CreateShaderModule(
+  impl_->info.vertex.module = shaders.AcquireModule(
       impl_->device, impl_->info.vertex.code, impl_->info.vertex.code_size);
   impl_->info.vertex.code = nullptr;
   impl_->info.vertex.code_size = 0;
@@ -240,11 +277,12 @@ Material* Material::Builder::Build() {
     assert(false);
   }
 
-  // Create the samplers.
+  // Get the samplers, shared with every material using the same ones.
+  RenderUtils::SamplerCache& sampler_cache = RenderUtils::SamplerCache::Get();
   std::vector<RenderAPI::Sampler> samplers;
   for (auto& it : impl_->samplers) {
     it.second.index = samplers.size();
-    samplers.push_back(RenderAPI::CreateSampler(impl_->device, it.second.info));
+    samplers.push_back(sampler_cache.Acquire(impl_->device, it.second.info));
   }
 
   // Map textures to samplers.
@@ -273,7 +311,7 @@ Material* Material::Builder::Build() {
             RenderAPI::SamplerAddressMode::kRepeat,
             RenderAPI::SamplerAddressMode::kRepeat,
             RenderAPI::SamplerAddressMode::kRepeat);
-        samplers.push_back(RenderAPI::CreateSampler(impl_->device, info));
+        samplers.push_back(sampler_cache.Acquire(impl_->device, info));
       }
       sampler_index = default_sampler;
     }
@@ -286,7 +324,9 @@ Material* Material::Builder::Build() {
     bindings[it.binding].stages = it.stages;
   }
 
-  // Create the descriptor layout.
+  // Get the descriptor layouts, shared with every material declaring the same
+  // bindings.
+  RenderUtils::LayoutCache& layout_cache = RenderUtils::LayoutCache::Get();
   for (auto& descriptor : impl_->descriptors) {
     RenderAPI::DescriptorSetLayoutCreateInfo descriptor_info;
     descriptor_info.bindings.resize(descriptor.bindings.size());
@@ -299,13 +339,13 @@ Material* Material::Builder::Build() {
       ++binding;
     }
     descriptor.layout =
-        RenderAPI::CreateDescriptorSetLayout(impl_->device, descriptor_info);
+        layout_cache.AcquireSetLayout(impl_->device, descriptor_info);
     impl_->layout_info.layouts.emplace_back(descriptor.layout);
   }
 
-  // Create the pipeline layout.
+  // Get the pipeline layout.
   impl_->info.layout =
-      RenderAPI::CreatePipelineLayout(impl_->device, impl_->layout_info);
+      layout_cache.AcquirePipelineLayout(impl_->device, impl_->layout_info);
 
   // Create the descriptor set pool.
   static constexpr uint32_t kNumBuffers = 3;
@@ -325,6 +365,11 @@ Material* Material::Builder::Build() {
         RenderAPI::DescriptorType::kUniformBuffer,
         impl_->num_uniform_buffers * kMaxBufferedInstances);
   }
+  if (impl_->num_dynamic_uniform_buffers) {
+    pool_info.pools.emplace_back(
+        RenderAPI::DescriptorType::kUniformBufferDynamic,
+        impl_->num_dynamic_uniform_buffers * kMaxBufferedInstances);
+  }
   if (!pool_info.pools.empty()) {
     pool_info.max_sets = kMaxBufferedInstances;
     descriptor_set_pool =
@@ -335,6 +380,7 @@ Material* Material::Builder::Build() {
   MaterialImpl* material = new MaterialImpl();
   material->device_ = impl_->device;
   material->pool_ = descriptor_set_pool;
+  material->pipeline_cache_ = impl_->pipeline_cache;
   material->info_ = std::move(impl_->info);
   material->descriptors_ = std::move(impl_->descriptors);
   material->samplers_ = std::move(samplers);
@@ -382,6 +428,7 @@ Material* Material::Builder::Build() {
   // Clean the builder for reuse.
   Material::BuilderDetails clean;
   clean.device = impl_->device;
+  clean.pipeline_cache = impl_->pipeline_cache;
   *impl_ = std::move(clean);
 
   return material;
@@ -393,29 +440,39 @@ MaterialImpl::~MaterialImpl() {
   if (pool_ != RenderAPI::kInvalidHandle) {
     RenderAPI::DestroyDescriptorSetPool(pool_);
   }
-  for (const auto& it : pipelines_) {
-    RenderAPI::DestroyGraphicsPipeline(it.second);
+  RenderUtils::ShaderCache& shaders = RenderUtils::ShaderCache::Get();
+  for (const auto& bucket : pipelines_) {
+    for (const auto& it : bucket.second) {
+      shaders.ReleasePipeline(it.pipeline);
+    }
   }
   for (const auto& it : samplers_) {
-    RenderAPI::DestroySampler(device_, it);
+    RenderUtils::SamplerCache::Get().Release(it);
   }
+  RenderUtils::LayoutCache& layouts = RenderUtils::LayoutCache::Get();
+  layouts.ReleasePipelineLayout(info_.layout);
   for (const auto& it : descriptors_) {
-    RenderAPI::DestroyDescriptorSetLayout(it.layout);
+    layouts.ReleaseSetLayout(it.layout);
   }
-  RenderAPI::DestroyPipelineLayout(device_, info_.layout);
-  RenderAPI::DestroyShaderModule(device_, info_.fragment.module);
-  RenderAPI::DestroyShaderModule(device_, info_.vertex.module);
+  shaders.ReleaseModule(info_.fragment.module);
+  shaders.ReleaseModule(info_.vertex.module);
 }
 
 RenderAPI::GraphicsPipeline MaterialImpl::GetPipeline(
     RenderAPI::RenderPass pass) {
-  const auto& it = pipelines_.find(pass);
-  if (it != pipelines_.cend()) {
-    return it->second;
+  RenderAPI::RenderPassCompatibility compatibility =
+      RenderAPI::GetRenderPassCompatibility(pass);
+  std::vector<CompatiblePipeline>& bucket = pipelines_[compatibility.hash];
+  for (const auto& it : bucket) {
+    if (it.compatibility == compatibility) {
+      return it.pipeline;
+    }
   }
+  // Materials with the same shaders and states share the pipeline.
   RenderAPI::GraphicsPipeline pipeline =
-      RenderAPI::CreateGraphicsPipeline(device_, pass, info_);
-  pipelines_[pass] = pipeline;
+      RenderUtils::ShaderCache::Get().AcquirePipeline(device_, pass, info_,
+                                                      pipeline_cache_);
+  bucket.push_back({std::move(compatibility), pipeline});
   return pipeline;
 }
 
@@ -439,7 +496,16 @@ MaterialInstance* MaterialImpl::CreateInstance() {
     for (uint32_t i = 0; i < src_set.bindings.size(); ++i) {
       params[i].type = src_set.bindings[i].type;
       size_t size = src_set.bindings[i].uniform.size;
-      if (size) {
+      if (src_set.bindings[i].ring) {
+        // Points at the ring once, offsets are supplied at bind time.
+        params[i].ring = src_set.bindings[i].ring;
+        params[i].data.size = size;
+        params[i].dynamic_index = static_cast<uint32_t>(
+            descriptors[descriptorIdx].dynamic_offsets.size());
+        params[i].dirty = true;
+        descriptors[descriptorIdx].dynamic_offsets.push_back(0);
+        descriptors[descriptorIdx].dirty = true;
+      } else if (size) {
         params[i].buffers = RenderUtils::BufferedBuffer::Create(
             device_, RenderAPI::BufferUsageFlagBits::kUniformBuffer, size);
         params[i].data.size = size;
@@ -456,6 +522,7 @@ MaterialInstance* MaterialImpl::CreateInstance() {
   instance->device_ = device_;
   instance->material_ = this;
   instance->descriptors_ = std::move(descriptors);
+  instance->dirty_ = true;
 
   // Copy default uniform data.
   uint32_t setIdx = 0;
@@ -484,6 +551,8 @@ MaterialParams* MaterialImpl::CreateParams(uint32_t set) const {
   auto& params = instance->params_;
   params.resize(src_set.bindings.size());
   for (uint32_t i = 0; i < src_set.bindings.size(); ++i) {
+    assert(!src_set.bindings[i].ring &&
+           "Dynamic uniforms are only supported by material instances!");
     params[i].type = src_set.bindings[i].type;
     size_t size = src_set.bindings[i].uniform.size;
     if (size) {
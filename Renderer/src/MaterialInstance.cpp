@@ -1,5 +1,7 @@
 #include "detail/MaterialInstance.h"
 
+#include <cassert>
+
 void MaterialInstance::Destroy(MaterialInstance* instance) {
   delete upcast(instance);
 }
@@ -21,6 +23,14 @@ void MaterialInstanceImpl::SetParam(uint32_t set, uint32_t binding,
   dirty_ = true;
 }
 
+void MaterialInstanceImpl::SetDynamicParam(uint32_t set, uint32_t binding,
+                                           const void* data) {
+  MaterialParam& param = descriptors_[set].params[binding];
+  assert(param.ring && "Binding is not a dynamic uniform!");
+  descriptors_[set].dynamic_offsets[param.dynamic_index] =
+      param.ring->Push(data, param.data.size);
+}
+
 void MaterialInstanceImpl::Commit() {
   if (!dirty_) {
     return;
@@ -60,6 +70,10 @@ void MaterialInstanceImpl::Commit() {
           RenderAPI::UnmapBuffer(param.buffers);
           write.buffers =
               &buffers.emplace_back(param.buffers, 0, param.data.size);
+        } else if (param.type ==
+                   RenderAPI::DescriptorType::kUniformBufferDynamic) {
+          write.buffers = &buffers.emplace_back(param.ring->GetBuffer(), 0,
+                                                param.data.size);
         } else if (param.type ==
                    RenderAPI::DescriptorType::kCombinedImageSampler) {
           write.images = &images.emplace_back(param.texture, param.sampler);
@@ -99,6 +113,12 @@ const RenderAPI::DescriptorSet* MaterialInstanceImpl::DescriptorSet(
     uint32_t set) const {
   return descriptors_[set].set;
 }
+const uint32_t* MaterialInstanceImpl::DynamicOffsets(uint32_t set) const {
+  return descriptors_[set].dynamic_offsets.data();
+}
+uint32_t MaterialInstanceImpl::DynamicOffsetsCount(uint32_t set) const {
+  return static_cast<uint32_t>(descriptors_[set].dynamic_offsets.size());
+}
 Material* MaterialInstanceImpl::GetMaterial() { return material_; }
 
 MaterialInstanceImpl::~MaterialInstanceImpl() {
@@ -122,12 +142,23 @@ void MaterialInstance::SetParam(uint32_t set, uint32_t binding,
   upcast(this)->SetParam(set, binding, data);
 }
 
+void MaterialInstance::SetDynamicParam(uint32_t set, uint32_t binding,
+                                       const void* data) {
+  upcast(this)->SetDynamicParam(set, binding, data);
+}
+
 void MaterialInstance::Commit() { upcast(this)->Commit(); }
 
 const RenderAPI::DescriptorSet* MaterialInstance::DescriptorSet(
     uint32_t set) const {
   return upcast(this)->DescriptorSet(set);
 }
+const uint32_t* MaterialInstance::DynamicOffsets(uint32_t set) const {
+  return upcast(this)->DynamicOffsets(set);
+}
+uint32_t MaterialInstance::DynamicOffsetsCount(uint32_t set) const {
+  return upcast(this)->DynamicOffsetsCount(set);
+}
 Material* MaterialInstance::GetMaterial() {
   return upcast(this)->GetMaterial();
 }
\ No newline at end of file
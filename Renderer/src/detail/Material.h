@@ -7,6 +7,10 @@
 #include <unordered_map>
 #include "../upcast.h"
 
+namespace RenderUtils {
+class UniformRing;
+}  // namespace RenderUtils
+
 struct ParamData {
   size_t size = 0;
   std::unique_ptr<uint8_t[]> data;
@@ -18,6 +22,7 @@ struct DescriptorData {
   RenderAPI::DescriptorBindingFlags flags = 0;
   RenderAPI::Sampler sampler;
   ParamData uniform;
+  RenderUtils::UniformRing* ring = nullptr;
 };
 struct DescriptorBindings {
   std::vector<DescriptorData> bindings;
@@ -41,8 +46,14 @@ class MaterialImpl : public Material {
   std::vector<RenderAPI::Sampler> samplers_;
   std::vector<DescriptorBindings> descriptors_;
   RenderAPI::GraphicsPipelineCreateInfo info_;
-  std::unordered_map<RenderAPI::RenderPass, RenderAPI::GraphicsPipeline>
-      pipelines_;
+  // By the hash of the render pass compatibility, compatible passes share a
+  // pipeline.
+  struct CompatiblePipeline {
+    RenderAPI::RenderPassCompatibility compatibility;
+    RenderAPI::GraphicsPipeline pipeline;
+  };
+  std::unordered_map<uint64_t, std::vector<CompatiblePipeline>> pipelines_;
+  RenderAPI::PipelineCache pipeline_cache_ = RenderAPI::kInvalidHandle;
   RenderAPI::DescriptorSetPool pool_;
 
   // Shader specialization.
@@ -2,6 +2,7 @@
 
 #include <RenderUtils/BufferedBuffer.h>
 #include <RenderUtils/BufferedDescriptorSet.h>
+#include <RenderUtils/UniformRing.h>
 #include <Renderer/Material.h>
 #include <Renderer/MaterialInstance.h>
 #include "Material.h"
@@ -12,11 +13,14 @@ struct MaterialParam {
   RenderUtils::BufferedBuffer buffers;
   RenderAPI::Sampler sampler;
   RenderAPI::ImageView texture = 0;
+  RenderUtils::UniformRing* ring = nullptr;
+  uint32_t dynamic_index = 0;
   bool dirty = false;
 };
 struct MaterialDescriptor {
   std::vector<MaterialParam> params;
   RenderUtils::BufferedDescriptorSet set;
+  std::vector<uint32_t> dynamic_offsets;
   bool dirty = false;
 };
 
@@ -26,9 +30,12 @@ class MaterialInstanceImpl : public MaterialInstance {
 
   void SetTexture(uint32_t set, uint32_t binding, RenderAPI::ImageView texture);
   void SetParam(uint32_t set, uint32_t binding, const void* data);
+  void SetDynamicParam(uint32_t set, uint32_t binding, const void* data);
   void Commit();
 
   const RenderAPI::DescriptorSet* DescriptorSet(uint32_t set) const;
+  const uint32_t* DynamicOffsets(uint32_t set) const;
+  uint32_t DynamicOffsetsCount(uint32_t set) const;
   Material* GetMaterial();
 
   ~MaterialInstanceImpl();
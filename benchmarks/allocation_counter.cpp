@@ -0,0 +1,75 @@
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+// Per thread, so threaded benchmarks only see their own allocations.
+thread_local uint64_t allocations_ = 0;
+
+void* Allocate(std::size_t size) {
+  ++allocations_;
+  void* memory = std::malloc(size ? size : 1);
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+// The allocation is preceded by the pointer malloc returned.
+void* AllocateAligned(std::size_t size, std::align_val_t alignment) {
+  ++allocations_;
+  const std::size_t align = static_cast<std::size_t>(alignment);
+  void* memory = std::malloc(size + align + sizeof(void*));
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  const uintptr_t start = reinterpret_cast<uintptr_t>(memory) + sizeof(void*);
+  void** aligned = reinterpret_cast<void**>((start + align - 1) & ~(align - 1));
+  aligned[-1] = memory;
+  return aligned;
+}
+
+void FreeAligned(void* memory) {
+  if (memory) {
+    std::free(static_cast<void**>(memory)[-1]);
+  }
+}
+}  // namespace
+
+uint64_t GetAllocationCount() { return allocations_; }
+
+void ReportAllocations(benchmark::State& state, uint64_t allocations) {
+  state.counters["allocs"] = benchmark::Counter(
+      static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new[](std::size_t size) { return Allocate(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+void operator delete[](void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return AllocateAligned(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return AllocateAligned(size, alignment);
+}
+void operator delete(void* memory, std::align_val_t) noexcept {
+  FreeAligned(memory);
+}
+void operator delete[](void* memory, std::align_val_t) noexcept {
+  FreeAligned(memory);
+}
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+  FreeAligned(memory);
+}
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept {
+  FreeAligned(memory);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+// Counts the global operator new calls of the calling thread. Linking
+// //benchmarks:allocation_counter replaces the global allocation functions.
+uint64_t GetAllocationCount();
+
+// Reports allocations as the per-iteration "allocs" counter.
+void ReportAllocations(benchmark::State& state, uint64_t allocations);
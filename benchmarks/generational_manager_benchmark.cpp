@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+#include "benchmarks/allocation_counter.h"
+#include "generational/generational.h"
+
+// Handle allocation in Generational::Manager.
+
+// Creates count handles and destroys them again, after the first iteration
+// every index comes from the free list.
+static void BM_ManagerCreateDestroy(benchmark::State& state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  Generational::Manager manager;
+  std::vector<Generational::HandleType> handles(count);
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    for (auto& handle : handles) {
+      handle = manager.Create();
+    }
+    for (auto handle : handles) {
+      manager.Destroy(handle);
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ManagerCreateDestroy)->Range(64, 64 << 10);
+
+static void BM_ManagerCreateDestroyN(benchmark::State& state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  Generational::Manager manager;
+  std::vector<Generational::HandleType> handles(count);
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    manager.CreateN(handles.data(), count);
+    manager.DestroyN(handles.data(), count);
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ManagerCreateDestroyN)->Range(64, 64 << 10);
+
+// The render graph builder's pattern: create a frame's handles, then Reset.
+static void BM_ManagerCreateReset(benchmark::State& state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  Generational::Manager manager;
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(manager.Create());
+    }
+    manager.Reset();
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ManagerCreateReset)->Range(64, 64 << 10);
+
+static void BM_ManagerIsAlive(benchmark::State& state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  Generational::Manager manager;
+  std::vector<Generational::HandleType> handles(count);
+  manager.CreateN(handles.data(), count);
+  // Half of the handles are stale.
+  for (size_t i = 1; i < count; i += 2) {
+    manager.Destroy(handles[i]);
+  }
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    for (auto handle : handles) {
+      benchmark::DoNotOptimize(manager.IsAlive(handle));
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ManagerIsAlive)->Range(64, 64 << 10);
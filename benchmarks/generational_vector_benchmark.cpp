@@ -0,0 +1,111 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+#include "benchmarks/allocation_counter.h"
+#include "generational/generational_vector.h"
+#include "generational/sparse_generational_vector.h"
+
+// Contiguous versus chunked GenerationalVector storage, and the sparse set
+// variant.
+
+namespace {
+// About the size of the larger backend objects.
+struct LargeObject {
+  uint64_t data[32];
+};
+
+template <typename T>
+using Contiguous = GenerationalVector<T, GenerationalStorage::Contiguous<T>>;
+template <typename T>
+using Chunked = GenerationalVector<T, GenerationalStorage::Chunked<T>>;
+}  // namespace
+
+// Fills an empty vector, growth dominates.
+template <typename Vector>
+static void BM_Create(benchmark::State& state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    Vector vector;
+    for (size_t i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(vector.Create(LargeObject()));
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_Create, Contiguous<LargeObject>)->Range(64, 64 << 10);
+BENCHMARK_TEMPLATE(BM_Create, Chunked<LargeObject>)->Range(64, 64 << 10);
+
+// Visits every element through its handle.
+template <typename Vector>
+static void BM_Lookup(benchmark::State& state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  Vector vector;
+  std::vector<Generational::Handle> handles;
+  for (size_t i = 0; i < count; ++i) {
+    handles.emplace_back(vector.Create(LargeObject()));
+  }
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    for (auto handle : handles) {
+      benchmark::DoNotOptimize(vector[handle].data[0]);
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_Lookup, Contiguous<LargeObject>)->Range(64, 64 << 10);
+BENCHMARK_TEMPLATE(BM_Lookup, Chunked<LargeObject>)->Range(64, 64 << 10);
+
+// Visits the live elements when every other element was destroyed. The
+// GenerationalVector has to go through the handles, the sparse set scans its
+// dense array.
+template <typename Vector>
+static void BM_IterateHandles(benchmark::State& state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  Vector vector;
+  std::vector<Generational::Handle> handles;
+  for (size_t i = 0; i < count; ++i) {
+    handles.emplace_back(vector.Create(LargeObject()));
+  }
+  std::vector<Generational::Handle> live;
+  for (size_t i = 0; i < count; ++i) {
+    if (i % 2) {
+      vector.Destroy(handles[i]);
+    } else {
+      live.emplace_back(handles[i]);
+    }
+  }
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    for (auto handle : live) {
+      benchmark::DoNotOptimize(vector[handle].data[0]);
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * live.size());
+}
+BENCHMARK_TEMPLATE(BM_IterateHandles, Chunked<LargeObject>)
+    ->Range(64, 64 << 10);
+
+static void BM_IterateSparse(benchmark::State& state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  SparseGenerationalVector<LargeObject> vector;
+  std::vector<Generational::Handle> handles;
+  for (size_t i = 0; i < count; ++i) {
+    handles.emplace_back(vector.Create(LargeObject()));
+  }
+  for (size_t i = 1; i < count; i += 2) {
+    vector.Destroy(handles[i]);
+  }
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    for (const auto& it : vector) {
+      benchmark::DoNotOptimize(it.data[0]);
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * vector.size());
+}
+BENCHMARK(BM_IterateSparse)->Range(64, 64 << 10);
@@ -0,0 +1,97 @@
+#include <benchmark/benchmark.h>
+#include <RenderAPI/RenderAPI.h>
+#include <Renderer/Material.h>
+#include <Renderer/MaterialInstance.h>
+#include <cstdint>
+#include <vector>
+#include "benchmarks/allocation_counter.h"
+
+// Material creation and instance updates on the null backend.
+
+namespace {
+constexpr size_t kBatchSize = 64;
+
+// The null backend doesn't look at the code.
+constexpr uint32_t kShaderCode[] = {0x07230203, 0, 0, 0, 0};
+
+struct Params {
+  float color[4];
+  float roughness;
+  float metallic;
+};
+
+RenderAPI::Device GetDevice() {
+  static RenderAPI::Device device =
+      RenderAPI::CreateDevice(RenderAPI::Create());
+  return device;
+}
+
+// A lit material with a uniform, two textures and a push constant.
+Material::Builder& SetupBuilder(Material::Builder& builder) {
+  const Params params = {};
+  return builder.VertexCode(kShaderCode, sizeof(kShaderCode))
+      .FragmentCode(kShaderCode, sizeof(kShaderCode))
+      .VertexAttribute(0, 0, RenderAPI::TextureFormat::kR32G32B32_SFLOAT, 0)
+      .VertexAttribute(1, 0, RenderAPI::TextureFormat::kR32G32_SFLOAT, 12)
+      .VertexBinding(0, 20)
+      .PushConstant(RenderAPI::ShaderStageFlagBits::kVertexBit, 64)
+      .Uniform(0, 0, RenderAPI::ShaderStageFlagBits::kFragmentBit,
+               sizeof(Params), &params)
+      .Texture(0, 1, RenderAPI::ShaderStageFlagBits::kFragmentBit, "linear")
+      .Texture(0, 2, RenderAPI::ShaderStageFlagBits::kFragmentBit, "linear")
+      .Sampler("linear");
+}
+}  // namespace
+
+// Materials are destroyed in batches with the timer paused.
+static void BM_MaterialBuild(benchmark::State& state) {
+  Material::Builder builder(GetDevice());
+  std::vector<Material*> materials(kBatchSize);
+
+  uint64_t allocations = 0;
+  for (auto _ : state) {
+    const uint64_t start = GetAllocationCount();
+    for (auto& material : materials) {
+      material = SetupBuilder(builder).Build();
+    }
+    allocations += GetAllocationCount() - start;
+
+    state.PauseTiming();
+    for (auto material : materials) {
+      Material::Destroy(material);
+    }
+    state.ResumeTiming();
+  }
+  ReportAllocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(BM_MaterialBuild);
+
+// Updates the uniform of every instance, as a scene would every frame.
+static void BM_MaterialInstanceCommit(benchmark::State& state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  Material::Builder builder(GetDevice());
+  Material* material = SetupBuilder(builder).Build();
+  std::vector<MaterialInstance*> instances(count);
+  for (auto& instance : instances) {
+    instance = material->CreateInstance();
+  }
+
+  Params params = {};
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    params.roughness += 1.0f;
+    for (auto instance : instances) {
+      instance->SetParam(0, 0, params);
+      instance->Commit();
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * count);
+
+  for (auto instance : instances) {
+    MaterialInstance::Destroy(instance);
+  }
+  Material::Destroy(material);
+}
+BENCHMARK(BM_MaterialInstanceCommit)->Range(8, 512);
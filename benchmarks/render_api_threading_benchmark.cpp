@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+#include <RenderAPI/RenderAPI.h>
+#include <mutex>
+#include <vector>
+#include "benchmarks/allocation_counter.h"
+#include "generational/concurrent_generational_vector.h"
+#include "generational/generational_vector.h"
+
+// Contention of the RenderAPI object tables: every thread creates a batch of
+// objects and destroys them again.
+
+namespace {
+constexpr size_t kBatchSize = 64;
+
+struct Object {
+  uint64_t data[4];
+};
+
+// The layout used before the tables were made thread-safe, behind a lock.
+GenerationalVector<Object> locked_vector_;
+std::mutex locked_vector_mutex_;
+ConcurrentGenerationalVector<Object> concurrent_vector_;
+
+RenderAPI::Device GetDevice() {
+  static RenderAPI::Device device =
+      RenderAPI::CreateDevice(RenderAPI::Create());
+  return device;
+}
+}  // namespace
+
+static void BM_LockedVectorCreateDestroy(benchmark::State& state) {
+  std::vector<Generational::Handle> handles(kBatchSize);
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    for (auto& handle : handles) {
+      std::lock_guard<std::mutex> lock(locked_vector_mutex_);
+      handle = locked_vector_.Create(Object());
+    }
+    for (auto handle : handles) {
+      std::lock_guard<std::mutex> lock(locked_vector_mutex_);
+      locked_vector_.Destroy(handle);
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(BM_LockedVectorCreateDestroy)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_ConcurrentVectorCreateDestroy(benchmark::State& state) {
+  std::vector<Generational::Handle> handles(kBatchSize);
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    for (auto& handle : handles) {
+      handle = concurrent_vector_.Create(Object());
+    }
+    for (auto handle : handles) {
+      concurrent_vector_.Destroy(handle);
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(BM_ConcurrentVectorCreateDestroy)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_ConcurrentVectorLookup(benchmark::State& state) {
+  std::vector<Generational::Handle> handles(kBatchSize);
+  for (auto& handle : handles) {
+    handle = concurrent_vector_.Create(Object());
+  }
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    for (auto handle : handles) {
+      benchmark::DoNotOptimize(concurrent_vector_[handle].data[0]);
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  for (auto handle : handles) {
+    concurrent_vector_.Destroy(handle);
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(BM_ConcurrentVectorLookup)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_CreateDestroyBuffers(benchmark::State& state) {
+  const RenderAPI::Device device = GetDevice();
+  std::vector<RenderAPI::Buffer> buffers(kBatchSize);
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    for (auto& buffer : buffers) {
+      buffer = RenderAPI::CreateBuffer(
+          device, RenderAPI::BufferUsageFlagBits::kUniformBuffer, 64);
+    }
+    for (auto buffer : buffers) {
+      RenderAPI::DestroyBuffer(buffer);
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(BM_CreateDestroyBuffers)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,236 @@
+#include <benchmark/benchmark.h>
+#include <RenderAPI/RenderAPI.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "benchmarks/allocation_counter.h"
+#include "render_graph/render_graph.h"
+#include "render_graph/render_graph_builder.h"
+#include "render_graph/render_graph_cache.h"
+
+// Render graph compilation and transient lookups on the null backend.
+
+namespace {
+RenderAPI::Device GetDevice() {
+  static RenderAPI::Device device =
+      RenderAPI::CreateDevice(RenderAPI::Create());
+  return device;
+}
+
+RenderGraphTextureDesc MakeTextureDesc(uint32_t width) {
+  RenderGraphTextureDesc desc = {};
+  desc.width = width;
+  desc.height = 1080;
+  desc.format = RenderAPI::TextureFormat::kR16G16B16A16_SFLOAT;
+  return desc;
+}
+
+// Pass i renders into a new target and reads the targets of passes i - 1 and
+// i / 2, the last pass is kept as a side effect. Widths repeat so transients
+// can be aliased.
+void SetupSyntheticPass(RenderGraphBuilder& builder,
+                        std::vector<RenderGraphResource>& targets,
+                        size_t pass) {
+  static constexpr uint32_t kWidths[] = {1920, 1280, 960, 640};
+  if (pass > 0) {
+    builder.Read(targets[pass - 1]);
+    builder.Read(targets[pass / 2]);
+  }
+  targets[pass] =
+      builder.CreateRenderTarget(MakeTextureDesc(kWidths[pass % 4]))
+          .textures[0];
+  if (pass + 1 == targets.size()) {
+    builder.SideEffect();
+  }
+}
+
+void AddSyntheticPasses(RenderGraphBuilder& builder,
+                        std::vector<RenderGraphPass>& passes,
+                        size_t num_passes) {
+  std::vector<RenderGraphResource> targets(num_passes);
+  for (size_t i = 0; i < num_passes; ++i) {
+    builder.SetCurrentPass(i);
+    SetupSyntheticPass(builder, targets, i);
+
+    RenderGraphPass pass;
+    pass.name = "Pass";
+    passes.emplace_back(std::move(pass));
+  }
+}
+}  // namespace
+
+// Building only, the passes are set up with the timer paused.
+static void BM_RenderGraphBuild(benchmark::State& state) {
+  const size_t num_passes = static_cast<size_t>(state.range(0));
+  RenderGraphCache cache;
+  cache.SetRenderObjects(GetDevice());
+  cache.PrepareBufferedResources(1);
+  RenderGraphBuilder builder(&cache);
+  std::vector<RenderGraphPass> passes;
+  // The first build creates the transients, later ones find them cached.
+  AddSyntheticPasses(builder, passes, num_passes);
+  builder.Build(passes);
+
+  uint64_t allocations = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    cache.Reset();
+    builder.Reset();
+    passes.clear();
+    AddSyntheticPasses(builder, passes, num_passes);
+    const uint64_t start = GetAllocationCount();
+    state.ResumeTiming();
+
+    std::vector<RenderGraphNode> nodes = builder.Build(passes);
+    benchmark::DoNotOptimize(nodes.data());
+    allocations += GetAllocationCount() - start;
+  }
+  ReportAllocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * num_passes);
+  cache.Destroy();
+}
+BENCHMARK(BM_RenderGraphBuild)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(5000)
+    ->Unit(benchmark::kMicrosecond);
+
+// Whole frames of the same graph, after the first frame per swapchain image
+// the compiled graph is reused and only the setup and recording remain.
+static void BM_RenderGraphFrame(benchmark::State& state) {
+  const size_t num_passes = static_cast<size_t>(state.range(0));
+  RenderGraph graph(GetDevice());
+  graph.BuildSwapChain(1920, 1080);
+  std::vector<RenderGraphResource> targets(num_passes);
+
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    graph.BeginFrame();
+    for (size_t i = 0; i < num_passes; ++i) {
+      graph.AddPass(
+          "Pass",
+          [&targets, i](RenderGraphBuilder& builder) {
+            SetupSyntheticPass(builder, targets, i);
+          },
+          [](RenderContext*, const Scope&) {});
+    }
+    graph.Render();
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  const RenderGraphCompileStats& stats = graph.GetCompileStats();
+  state.counters["compile_hit_rate"] =
+      static_cast<double>(stats.hits) / (stats.hits + stats.misses);
+  state.SetItemsProcessed(state.iterations() * num_passes);
+}
+BENCHMARK(BM_RenderGraphFrame)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(5000)
+    ->Unit(benchmark::kMicrosecond);
+
+// Declaring the passes of a frame, with render functions capturing more than
+// std::function stores inline. Only AddPass is counted in the allocations.
+static void BM_RenderGraphAddPass(benchmark::State& state) {
+  const size_t num_passes = static_cast<size_t>(state.range(0));
+  RenderGraph graph(GetDevice());
+  graph.BuildSwapChain(1920, 1080);
+  std::vector<RenderGraphResource> targets(num_passes);
+  std::array<float, 32> matrices = {};
+
+  uint64_t allocations = 0;
+  for (auto _ : state) {
+    graph.BeginFrame();
+    const uint64_t start = GetAllocationCount();
+    for (size_t i = 0; i < num_passes; ++i) {
+      graph.AddPass(
+          "Pass",
+          [&targets, i](RenderGraphBuilder& builder) {
+            SetupSyntheticPass(builder, targets, i);
+          },
+          [matrices](RenderContext*, const Scope&) {
+            benchmark::DoNotOptimize(matrices.data());
+          });
+    }
+    allocations += GetAllocationCount() - start;
+    graph.Render();
+  }
+  ReportAllocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * num_passes);
+}
+BENCHMARK(BM_RenderGraphAddPass)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Unit(benchmark::kMicrosecond);
+
+// Every texture has its own description and lifetime, each lookup hits.
+static void BM_RenderGraphCacheTextureLookup(benchmark::State& state) {
+  const uint32_t count = static_cast<uint32_t>(state.range(0));
+  RenderGraphCache cache;
+  cache.SetRenderObjects(GetDevice());
+  cache.PrepareBufferedResources(1);
+
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    cache.Reset();
+    for (uint32_t i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(
+          cache.CreateTransientTexture(MakeTextureDesc(64 + i), i, i));
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * count);
+  cache.Destroy();
+}
+BENCHMARK(BM_RenderGraphCacheTextureLookup)->Range(8, 1024);
+
+// Textures sharing a description and alive at the same time, each lookup
+// skips the ones already handed out this frame.
+static void BM_RenderGraphCacheTextureLookupSameDesc(benchmark::State& state) {
+  const uint32_t count = static_cast<uint32_t>(state.range(0));
+  RenderGraphCache cache;
+  cache.SetRenderObjects(GetDevice());
+  cache.PrepareBufferedResources(1);
+
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    cache.Reset();
+    for (uint32_t i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(
+          cache.CreateTransientTexture(MakeTextureDesc(64), 0, count));
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * count);
+  cache.Destroy();
+}
+BENCHMARK(BM_RenderGraphCacheTextureLookupSameDesc)->Range(8, 1024);
+
+static void BM_RenderGraphCacheFramebufferLookup(benchmark::State& state) {
+  const uint32_t count = static_cast<uint32_t>(state.range(0));
+  RenderGraphCache cache;
+  cache.SetRenderObjects(GetDevice());
+  cache.PrepareBufferedResources(1);
+  std::vector<RenderGraphFramebufferDesc> descs(count);
+  std::vector<std::vector<RenderAPI::ImageView>> textures(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    descs[i].textures.emplace_back(MakeTextureDesc(64 + i));
+    textures[i].emplace_back(
+        cache.CreateTransientTexture(descs[i].textures[0], i, i));
+  }
+
+  const uint64_t allocations = GetAllocationCount();
+  for (auto _ : state) {
+    cache.Reset();
+    for (uint32_t i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(
+          cache.CreateTransientFramebuffer(descs[i], textures[i]));
+    }
+  }
+  ReportAllocations(state, GetAllocationCount() - allocations);
+  state.SetItemsProcessed(state.iterations() * count);
+  cache.Destroy();
+}
+BENCHMARK(BM_RenderGraphCacheFramebufferLookup)->Range(8, 1024);
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include "generational.h"
+
+// GenerationalVector that can be used from several threads at once.
+// Elements live in fixed size chunks that never move, so lookups are lock-free
+// and references stay valid while other threads create objects. Creation and
+// destruction are spread over shards, each with its own lock, free list and
+// chunks. Destroyed slots are reused last in first out through a free list
+// threaded through the slots, like Generational::Manager.
+//
+// The elements themselves are not synchronized: an element must not be used
+// while another thread destroys its handle.
+template <typename T>
+class ConcurrentGenerationalVector {
+ public:
+  ConcurrentGenerationalVector();
+  ~ConcurrentGenerationalVector();
+
+  template <typename... Args>
+  Generational::Handle Create(Args&&... args);
+  Generational::Handle Create(T&& data);
+  void Destroy(Generational::Handle handle);
+  bool IsAlive(Generational::Handle handle) const;
+
+  T& operator[](Generational::Handle handle);
+  const T& operator[](Generational::Handle handle) const;
+
+ private:
+  static constexpr size_t kChunkBits = 8;
+  static constexpr size_t kChunkSize = size_t(1) << kChunkBits;
+  static constexpr size_t kMaxChunks = 4096;
+  static constexpr size_t kNumShards = 8;
+
+  struct Slot {
+    T value;
+    std::atomic<uint32_t> generation{0};
+    // Index + 1 of the next free slot of the shard while the slot is free, 0
+    // ends the list. Guarded by the shard's mutex.
+    size_t next_free = 0;
+  };
+  struct Chunk {
+    Slot slots[kChunkSize];
+    size_t shard;
+  };
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    // Index + 1 of the first free slot, 0 if there is none.
+    size_t free_head = 0;
+    size_t chunk = 0;
+    size_t chunk_used = kChunkSize;
+  };
+
+  std::unique_ptr<std::atomic<Chunk*>[]> chunks_;
+  std::atomic<size_t> num_chunks_{0};
+  Shard shards_[kNumShards];
+
+  static size_t CurrentShard();
+  size_t AllocateIndex();
+  Slot& GetSlot(size_t index) const;
+};
+
+template <typename T>
+ConcurrentGenerationalVector<T>::ConcurrentGenerationalVector()
+    : chunks_(new std::atomic<Chunk*>[kMaxChunks]) {
+  for (size_t i = 0; i < kMaxChunks; ++i) {
+    chunks_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+ConcurrentGenerationalVector<T>::~ConcurrentGenerationalVector() {
+  // Failed allocations may have counted chunks past the end.
+  const size_t num_chunks =
+      std::min(num_chunks_.load(std::memory_order_acquire), kMaxChunks);
+  for (size_t i = 0; i < num_chunks; ++i) {
+    delete chunks_[i].load(std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+size_t ConcurrentGenerationalVector<T>::CurrentShard() {
+  static thread_local const size_t shard =
+      std::hash<std::thread::id>()(std::this_thread::get_id()) % kNumShards;
+  return shard;
+}
+
+template <typename T>
+size_t ConcurrentGenerationalVector<T>::AllocateIndex() {
+  const size_t shard_index = CurrentShard();
+  Shard& shard = shards_[shard_index];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (shard.free_head != 0) {
+    const size_t index = shard.free_head - 1;
+    shard.free_head = GetSlot(index).next_free;
+    return index;
+  }
+
+  if (shard.chunk_used == kChunkSize) {
+    const size_t next_chunk =
+        num_chunks_.fetch_add(1, std::memory_order_relaxed);
+    if (next_chunk >= kMaxChunks) {
+      throw std::runtime_error("out of handles!");
+    }
+    shard.chunk = next_chunk;
+    Chunk* chunk = new Chunk();
+    chunk->shard = shard_index;
+    chunks_[shard.chunk].store(chunk, std::memory_order_release);
+    shard.chunk_used = 0;
+  }
+  return (shard.chunk << kChunkBits) | shard.chunk_used++;
+}
+
+template <typename T>
+typename ConcurrentGenerationalVector<T>::Slot&
+ConcurrentGenerationalVector<T>::GetSlot(size_t index) const {
+  Chunk* chunk = chunks_[index >> kChunkBits].load(std::memory_order_acquire);
+  return chunk->slots[index & (kChunkSize - 1)];
+}
+
+template <typename T>
+template <typename... Args>
+Generational::Handle ConcurrentGenerationalVector<T>::Create(Args&&... args) {
+  const size_t index = AllocateIndex();
+  Slot& slot = GetSlot(index);
+  slot.value = T(std::forward<Args>(args)...);
+  // Index 0 is the invalid handle.
+  return Generational::Handle(
+      index + 1, slot.generation.load(std::memory_order_relaxed));
+}
+
+template <typename T>
+Generational::Handle ConcurrentGenerationalVector<T>::Create(T&& data) {
+  const size_t index = AllocateIndex();
+  Slot& slot = GetSlot(index);
+  slot.value = std::move(data);
+  return Generational::Handle(
+      index + 1, slot.generation.load(std::memory_order_relaxed));
+}
+
+template <typename T>
+void ConcurrentGenerationalVector<T>::Destroy(Generational::Handle handle) {
+  assert(IsAlive(handle) && "Handle already destroyed!");
+  const size_t index = handle.Index() - 1;
+  Chunk* chunk = chunks_[index >> kChunkBits].load(std::memory_order_acquire);
+  Slot& slot = chunk->slots[index & (kChunkSize - 1)];
+  // Only the destroying thread writes the generation, no need for an RMW.
+  slot.generation.store(slot.generation.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+
+  Shard& shard = shards_[chunk->shard];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  slot.next_free = shard.free_head;
+  shard.free_head = index + 1;
+}
+
+template <typename T>
+bool ConcurrentGenerationalVector<T>::IsAlive(
+    Generational::Handle handle) const {
+  const size_t index = handle.Index() - 1;
+  if (handle.Index() == 0 || (index >> kChunkBits) >= kMaxChunks) {
+    return false;
+  }
+  const Chunk* chunk =
+      chunks_[index >> kChunkBits].load(std::memory_order_acquire);
+  if (!chunk) {
+    return false;
+  }
+  const Slot& slot = chunk->slots[index & (kChunkSize - 1)];
+  return slot.generation.load(std::memory_order_relaxed) ==
+         static_cast<uint32_t>(handle.Generation());
+}
+
+template <typename T>
+T& ConcurrentGenerationalVector<T>::operator[](Generational::Handle handle) {
+  assert(IsAlive(handle) && "Invalid handle!");
+  return GetSlot(handle.Index() - 1).value;
+}
+
+template <typename T>
+const T& ConcurrentGenerationalVector<T>::operator[](
+    Generational::Handle handle) const {
+  assert(IsAlive(handle) && "Invalid handle!");
+  return GetSlot(handle.Index() - 1).value;
+}
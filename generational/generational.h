@@ -1,35 +1,138 @@
 #pragma once
 
+#include <cassert>
+#include <cstddef>
 #include <cstdint>
-#include <queue>
 #include <vector>
 
 namespace Generational {
 using HandleType = uint64_t;
 constexpr HandleType kInvalidHandle = 0;
+
+// Bit layout of Handle, generation in the high bits.
+constexpr uint32_t kDefaultIndexBits = 32;
+constexpr uint32_t kDefaultGenerationBits = 32;
+
 struct Handle {
   HandleType id;
 
   Handle() = default;
   Handle(HandleType id);
-  Handle(HandleType index, uint8_t generation);
+  Handle(HandleType index, HandleType generation);
   HandleType Index() const;
   HandleType Generation() const;
   operator HandleType() const;
 };
 
-class Manager {
+// Hands out handles made of an index and a generation. Destroyed indices are
+// reused last in first out through a free list threaded through the entries,
+// their generation is bumped so stale handles are detected.
+template <uint32_t kIndexBits, uint32_t kGenerationBits>
+class BasicManager {
  public:
-  Manager();
-  Handle Create();
-  bool IsAlive(Handle handle) const;
-  void Destroy(Handle handle);
+  static_assert(kIndexBits + kGenerationBits <= sizeof(HandleType) * 8,
+                "Handle bits don't fit in a HandleType!");
+  static_assert(kIndexBits > 0 && kGenerationBits > 0,
+                "Handles need both index and generation bits!");
+
+  static constexpr HandleType kIndexMask =
+      (HandleType(1) << (kIndexBits - 1) << 1) - 1;
+  static constexpr HandleType kGenerationMask =
+      (HandleType(1) << (kGenerationBits - 1) << 1) - 1;
+
+  static HandleType MakeHandle(HandleType index, HandleType generation) {
+    return ((generation & kGenerationMask) << kIndexBits) | index;
+  }
+  static HandleType Index(HandleType handle) { return handle & kIndexMask; }
+  static HandleType Generation(HandleType handle) {
+    return (handle >> kIndexBits) & kGenerationMask;
+  }
 
+  BasicManager() { entries_.resize(1); }
+
+  HandleType Create();
+  bool IsAlive(HandleType handle) const;
+  void Destroy(HandleType handle);
+
+  // Batch versions, handles are written to / read from the array.
+  void CreateN(HandleType* handles, size_t count);
+  void DestroyN(const HandleType* handles, size_t count);
+
+  // Invalidates every handle, keeps the memory.
   void Reset();
 
  private:
-  std::queue<HandleType> free_indices_;
-  std::vector<uint8_t> generations_;
+  // A live entry holds its own handle. A free entry holds the index of the
+  // next free entry (0 ends the list) and the generation of its next handle.
+  std::vector<HandleType> entries_;
+  HandleType free_head_ = 0;
 };
 
-}  // namespace Generational
\ No newline at end of file
+using Manager = BasicManager<kDefaultIndexBits, kDefaultGenerationBits>;
+
+template <uint32_t kIndexBits, uint32_t kGenerationBits>
+HandleType BasicManager<kIndexBits, kGenerationBits>::Create() {
+  if (free_head_ != 0) {
+    const HandleType idx = free_head_;
+    const HandleType entry = entries_[idx];
+    free_head_ = Index(entry);
+    entries_[idx] = MakeHandle(idx, Generation(entry));
+    return entries_[idx];
+  }
+  const HandleType idx = entries_.size();
+  assert(idx <= kIndexMask && "Out of handles!");
+  entries_.push_back(MakeHandle(idx, 0));
+  return entries_.back();
+}
+
+template <uint32_t kIndexBits, uint32_t kGenerationBits>
+bool BasicManager<kIndexBits, kGenerationBits>::IsAlive(
+    HandleType handle) const {
+  const HandleType idx = Index(handle);
+  return idx != 0 && idx < entries_.size() && entries_[idx] == handle;
+}
+
+template <uint32_t kIndexBits, uint32_t kGenerationBits>
+void BasicManager<kIndexBits, kGenerationBits>::Destroy(HandleType handle) {
+  assert(IsAlive(handle) && "Handle already destroyed!");
+  const HandleType idx = Index(handle);
+  entries_[idx] = MakeHandle(free_head_, Generation(handle) + 1);
+  free_head_ = idx;
+}
+
+template <uint32_t kIndexBits, uint32_t kGenerationBits>
+void BasicManager<kIndexBits, kGenerationBits>::CreateN(HandleType* handles,
+                                                        size_t count) {
+  size_t i = 0;
+  for (; i < count && free_head_ != 0; ++i) {
+    handles[i] = Create();
+  }
+  if (i == count) {
+    return;
+  }
+
+  // The free list is empty, append the rest in one go.
+  HandleType idx = entries_.size();
+  assert(idx + (count - i) - 1 <= kIndexMask && "Out of handles!");
+  entries_.resize(entries_.size() + (count - i));
+  for (; i < count; ++i, ++idx) {
+    entries_[idx] = MakeHandle(idx, 0);
+    handles[i] = entries_[idx];
+  }
+}
+
+template <uint32_t kIndexBits, uint32_t kGenerationBits>
+void BasicManager<kIndexBits, kGenerationBits>::DestroyN(
+    const HandleType* handles, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    Destroy(handles[i]);
+  }
+}
+
+template <uint32_t kIndexBits, uint32_t kGenerationBits>
+void BasicManager<kIndexBits, kGenerationBits>::Reset() {
+  entries_.resize(1);
+  free_head_ = 0;
+}
+
+}  // namespace Generational
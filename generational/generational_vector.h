@@ -1,10 +1,75 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
 #include <vector>
 #include "generational.h"
 
+namespace GenerationalStorage {
+// Elements in a single std::vector. Growing moves every element.
 template <typename T>
+class Contiguous {
+ public:
+  size_t size() const { return vector_.size(); }
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    vector_.emplace_back(std::forward<Args>(args)...);
+  }
+  T& operator[](size_t index) { return vector_[index]; }
+  const T& operator[](size_t index) const { return vector_[index]; }
+
+ private:
+  std::vector<T> vector_;
+};
+
+// Elements in fixed size chunks. Growing allocates a chunk and never moves
+// elements, so references stay valid while new elements are created.
+template <typename T, size_t kChunkSize = 256>
+class Chunked {
+ public:
+  static_assert((kChunkSize & (kChunkSize - 1)) == 0,
+                "Chunk size must be a power of two!");
+
+  Chunked() = default;
+  Chunked(const Chunked&) = delete;
+  Chunked& operator=(const Chunked&) = delete;
+  ~Chunked() {
+    for (size_t i = 0; i < size_; ++i) {
+      (*this)[i].~T();
+    }
+  }
+
+  size_t size() const { return size_; }
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    if (size_ == chunks_.size() * kChunkSize) {
+      chunks_.emplace_back(new Storage[kChunkSize]);
+    }
+    new (&chunks_[size_ / kChunkSize][size_ % kChunkSize])
+        T(std::forward<Args>(args)...);
+    ++size_;
+  }
+  T& operator[](size_t index) {
+    return *std::launder(reinterpret_cast<T*>(
+        &chunks_[index / kChunkSize][index % kChunkSize]));
+  }
+  const T& operator[](size_t index) const {
+    return *std::launder(reinterpret_cast<const T*>(
+        &chunks_[index / kChunkSize][index % kChunkSize]));
+  }
+
+ private:
+  struct alignas(T) Storage {
+    std::byte data[sizeof(T)];
+  };
+  std::vector<std::unique_ptr<Storage[]>> chunks_;
+  size_t size_ = 0;
+};
+}  // namespace GenerationalStorage
+
+template <typename T, typename Storage = GenerationalStorage::Chunked<T>>
 class GenerationalVector {
  public:
   template <typename... Args>
@@ -16,13 +81,13 @@ class GenerationalVector {
   const T& operator[](Generational::Handle handle) const;
 
  private:
-  std::vector<T> vector_;
+  Storage vector_;
   Generational::Manager manager_;
 };
 
-template <typename T>
+template <typename T, typename Storage>
 template <typename... Args>
-Generational::Handle GenerationalVector<T>::Create(Args&&... args) {
+Generational::Handle GenerationalVector<T, Storage>::Create(Args&&... args) {
   Generational::Handle handle = manager_.Create();
   auto idx = handle.Index() - 1;
   if (vector_.size() <= idx) {
@@ -33,31 +98,32 @@ Generational::Handle GenerationalVector<T>::Create(Args&&... args) {
   return handle;
 }
 
-template <typename T>
-Generational::Handle GenerationalVector<T>::Create(T&& data) {
+template <typename T, typename Storage>
+Generational::Handle GenerationalVector<T, Storage>::Create(T&& data) {
   Generational::Handle handle = manager_.Create();
   auto idx = handle.Index() - 1;
   if (vector_.size() <= idx) {
-    vector_.emplace_back(data);
+    vector_.emplace_back(std::move(data));
   } else {
-    vector_[idx] = data;
+    vector_[idx] = std::move(data);
   }
   return handle;
 }
 
-template <typename T>
-void GenerationalVector<T>::Destroy(Generational::Handle handle) {
+template <typename T, typename Storage>
+void GenerationalVector<T, Storage>::Destroy(Generational::Handle handle) {
   assert(manager_.IsAlive(handle) && "Handle already destroyed!");
   manager_.Destroy(handle);
 }
 
-template <typename T>
-T& GenerationalVector<T>::operator[](Generational::Handle handle) {
+template <typename T, typename Storage>
+T& GenerationalVector<T, Storage>::operator[](Generational::Handle handle) {
   assert(manager_.IsAlive(handle) && "Invalid handle!");
   return vector_[handle.Index() - 1];
 }
-template <typename T>
-const T& GenerationalVector<T>::operator[](Generational::Handle handle) const {
+template <typename T, typename Storage>
+const T& GenerationalVector<T, Storage>::operator[](
+    Generational::Handle handle) const {
   assert(manager_.IsAlive(handle) && "Invalid handle!");
   return vector_[handle.Index() - 1];
 }
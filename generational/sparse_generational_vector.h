@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "generational.h"
+
+// GenerationalVector keeping the live elements packed in a dense array, so
+// iterating them is a linear scan. Handles map to dense positions through a
+// sparse index, Destroy moves the last element into the hole and destructs it.
+//
+// Elements move on Destroy: references are only valid until the next Destroy.
+template <typename T>
+class SparseGenerationalVector {
+ public:
+  template <typename... Args>
+  Generational::Handle Create(Args&&... args);
+  Generational::Handle Create(T&& data);
+  void Destroy(Generational::Handle handle);
+  bool IsAlive(Generational::Handle handle) const;
+
+  T& operator[](Generational::Handle handle);
+  const T& operator[](Generational::Handle handle) const;
+
+  // Live elements, in no particular order.
+  size_t size() const { return dense_.size(); }
+  bool empty() const { return dense_.empty(); }
+  typename std::vector<T>::iterator begin() { return dense_.begin(); }
+  typename std::vector<T>::iterator end() { return dense_.end(); }
+  typename std::vector<T>::const_iterator begin() const {
+    return dense_.begin();
+  }
+  typename std::vector<T>::const_iterator end() const { return dense_.end(); }
+
+  // Calls fn(handle, element) for every live element. fn must not create or
+  // destroy elements.
+  template <typename Fn>
+  void ForEach(Fn&& fn);
+  template <typename Fn>
+  void ForEach(Fn&& fn) const;
+
+ private:
+  Generational::Manager manager_;
+  // Dense position by handle index.
+  std::vector<uint32_t> sparse_;
+  std::vector<T> dense_;
+  std::vector<Generational::Handle> dense_handles_;
+
+  void Insert(Generational::Handle handle);
+};
+
+template <typename T>
+void SparseGenerationalVector<T>::Insert(Generational::Handle handle) {
+  const auto idx = handle.Index();
+  if (sparse_.size() <= idx) {
+    sparse_.resize(idx + 1);
+  }
+  sparse_[idx] = static_cast<uint32_t>(dense_handles_.size());
+  dense_handles_.emplace_back(handle);
+}
+
+template <typename T>
+template <typename... Args>
+Generational::Handle SparseGenerationalVector<T>::Create(Args&&... args) {
+  Generational::Handle handle = manager_.Create();
+  dense_.emplace_back(std::forward<Args>(args)...);
+  Insert(handle);
+  return handle;
+}
+
+template <typename T>
+Generational::Handle SparseGenerationalVector<T>::Create(T&& data) {
+  Generational::Handle handle = manager_.Create();
+  dense_.emplace_back(std::move(data));
+  Insert(handle);
+  return handle;
+}
+
+template <typename T>
+void SparseGenerationalVector<T>::Destroy(Generational::Handle handle) {
+  assert(IsAlive(handle) && "Handle already destroyed!");
+  const uint32_t position = sparse_[handle.Index()];
+  const uint32_t last = static_cast<uint32_t>(dense_.size()) - 1;
+  if (position != last) {
+    dense_[position] = std::move(dense_[last]);
+    dense_handles_[position] = dense_handles_[last];
+    sparse_[dense_handles_[position].Index()] = position;
+  }
+  dense_.pop_back();
+  dense_handles_.pop_back();
+  manager_.Destroy(handle);
+}
+
+template <typename T>
+bool SparseGenerationalVector<T>::IsAlive(Generational::Handle handle) const {
+  return handle.Index() != 0 && handle.Index() < sparse_.size() &&
+         manager_.IsAlive(handle);
+}
+
+template <typename T>
+T& SparseGenerationalVector<T>::operator[](Generational::Handle handle) {
+  assert(IsAlive(handle) && "Invalid handle!");
+  return dense_[sparse_[handle.Index()]];
+}
+
+template <typename T>
+const T& SparseGenerationalVector<T>::operator[](
+    Generational::Handle handle) const {
+  assert(IsAlive(handle) && "Invalid handle!");
+  return dense_[sparse_[handle.Index()]];
+}
+
+template <typename T>
+template <typename Fn>
+void SparseGenerationalVector<T>::ForEach(Fn&& fn) {
+  for (size_t i = 0; i < dense_.size(); ++i) {
+    fn(dense_handles_[i], dense_[i]);
+  }
+}
+
+template <typename T>
+template <typename Fn>
+void SparseGenerationalVector<T>::ForEach(Fn&& fn) const {
+  for (size_t i = 0; i < dense_.size(); ++i) {
+    fn(dense_handles_[i], dense_[i]);
+  }
+}
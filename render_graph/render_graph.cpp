@@ -1,13 +1,12 @@
 #include "render_graph.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
 RenderGraph::RenderGraph(RenderAPI::Device device)
     : device_(device), builder_(&cache_) {
-  command_pool_ = RenderAPI::CreateCommandPool(
-      device_, RenderAPI::CommandPoolCreateFlag::kResetCommand);
-  cache_.SetRenderObjects(device_, command_pool_);
+  cache_.SetRenderObjects(device_);
 }
 
 RenderGraph::~RenderGraph() { Destroy(); }
@@ -24,10 +23,6 @@ void RenderGraph::Destroy() {
     RenderAPI::DestroySwapChain(swapchain_);
     swapchain_ = RenderAPI::kInvalidHandle;
   }
-  if (command_pool_ != RenderAPI::kInvalidHandle) {
-    RenderAPI::DestroyCommandPool(command_pool_);
-    command_pool_ = RenderAPI::kInvalidHandle;
-  }
   DestroySwapChain();
   device_ = RenderAPI::kInvalidHandle;
 }
@@ -35,6 +30,7 @@ void RenderGraph::Destroy() {
 void RenderGraph::DestroySwapChain() {
   RenderAPI::DeviceWaitIdle(device_);
   DestroySyncObjects();
+  compiled_graphs_.clear();
 
   if (backbuffer_render_pass_ != RenderAPI::kInvalidHandle) {
     RenderAPI::DestroyRenderPass(backbuffer_render_pass_);
@@ -64,32 +60,102 @@ void RenderGraph::BuildSwapChain(uint32_t width, uint32_t height) {
   CreateSyncObjects();
 }
 
-std::vector<RenderGraphNode> RenderGraph::Compile() {
+std::vector<RenderGraphNode>& RenderGraph::Compile() {
   AddPass("Present",
           [this](RenderGraphBuilder& builder) {
             builder.Read(backbuffer_resource_);
+            builder.SideEffect();
           },
           [this](RenderContext* context, const Scope& scope) {});
 
-  return builder_.Build(passes_);
+  const uint64_t hash = builder_.ComputeKey(passes_.size(), graph_key_);
+  for (size_t i = 0; i < compiled_graphs_.size(); ++i) {
+    CompiledGraph& graph = compiled_graphs_[i];
+    if (graph.hash != hash || graph.key != graph_key_) {
+      continue;
+    }
+    // Its memory is still used by a frame in flight, another graph may be
+    // free. If some of its transients were evicted, build it again.
+    const RenderGraphCache::RetainResult retained =
+        cache_.RetainTransients(graph.transients);
+    if (retained == RenderGraphCache::RetainResult::kInUse) {
+      continue;
+    }
+    if (retained == RenderGraphCache::RetainResult::kDestroyed) {
+      compiled_graphs_.erase(compiled_graphs_.begin() + i);
+      break;
+    }
+
+    ++compile_stats_.hits;
+    for (const auto& it : builder_.record_jobs_) {
+      passes_[it.first].record_jobs = it.second;
+    }
+    size_t node_pass = 0;
+    for (auto& node : graph.nodes) {
+      for (auto& render_pass : node.render_passes) {
+        for (auto& pass : render_pass.passes) {
+          pass = &passes_[graph.node_passes[node_pass++]];
+        }
+      }
+    }
+    builder_.SetClearValues(graph.node_targets, graph.nodes);
+    backbuffer_node_ = graph.backbuffer_node;
+    std::rotate(compiled_graphs_.begin(), compiled_graphs_.begin() + i,
+                compiled_graphs_.begin() + i + 1);
+    for (auto& pass : passes_) {
+      pass.scope.textures_ = &compiled_graphs_.front().textures;
+    }
+    return compiled_graphs_.front().nodes;
+  }
+
+  ++compile_stats_.misses;
+  CompiledGraph graph;
+  graph.hash = hash;
+  graph.key = graph_key_;
+  graph.nodes = builder_.Build(passes_);
+  for (const auto& node : graph.nodes) {
+    for (const auto& render_pass : node.render_passes) {
+      for (const auto* pass : render_pass.passes) {
+        graph.node_passes.emplace_back(pass - passes_.data());
+      }
+    }
+  }
+  graph.textures = builder_.scope_textures_;
+  graph.node_targets = builder_.node_targets_;
+  graph.backbuffer_node = builder_.GetFirstNodeUse(backbuffer_resource_);
+  graph.transients = cache_.GetFrameTransients();
+  backbuffer_node_ = graph.backbuffer_node;
+
+  if (compiled_graphs_.size() > max_frames_in_flight) {
+    compiled_graphs_.pop_back();
+  }
+  compiled_graphs_.insert(compiled_graphs_.begin(), std::move(graph));
+  for (auto& pass : passes_) {
+    pass.scope.textures_ = &compiled_graphs_.front().textures;
+  }
+  return compiled_graphs_.front().nodes;
 }
 
 void RenderGraph::BeginFrame() {
   cache_.Reset();
   builder_.Reset();
   passes_.clear();
+  arena_.Reset();
   AcquireBackbuffer();
 }
 
 void RenderGraph::Render() {
   // Compile the pass (should this be exposed?)
-  std::vector<RenderGraphNode> nodes = Compile();
+  std::vector<RenderGraphNode>& nodes = Compile();
 
   // (This should be removed) If the CPU is ahead, wait on fences.
   RenderAPI::WaitForFences(&backbuffer_fences_[current_frame_], 1, true,
                            std::numeric_limits<uint64_t>::max());
   RenderAPI::ResetFences(&backbuffer_fences_[current_frame_], 1);
 
+  // The oldest frame in flight has retired, its unused transients can go.
+  cache_.EvictUnused(max_frames_in_flight);
+
   // Submit work from the renderer passes.
   RenderAPI::Semaphore render_complete_semaphore =
       ExecuteRenderPasses(nodes, present_semaphores_[current_frame_]);
@@ -108,84 +174,210 @@ void RenderGraph::Render() {
   current_frame_ = (current_frame_ + 1) % max_frames_in_flight;
 }
 
-void RenderGraph::AddPass(const std::string& name, RenderGraphSetupFn setup_fn,
-                          RenderGraphRenderFn render_fn) {
-  RenderGraphPass pass;
-  pass.name = name;
-  pass.fn = std::move(render_fn);
-  pass.setup = std::move(setup_fn);
+void RenderGraph::RecordNode(RenderGraphNode& node, RenderContext& context) {
+  context.cmd = node.render_cmd;
+  RenderAPI::CmdBegin(context.cmd);
+  if (node.barrier.src_stages) {
+    RenderAPI::CmdPipelineBarrier(context.cmd, node.barrier);
+  }
 
-  builder_.SetCurrentPass(passes_.size());
-  if (pass.setup) {
-    pass.setup(builder_);
+  for (auto& render_pass : node.render_passes) {
+    if (render_pass.framebuffer.pass != RenderAPI::kInvalidHandle &&
+        render_pass.framebuffer.framebuffer != RenderAPI::kInvalidHandle) {
+      const bool secondary = !render_pass.secondary_cmds.empty();
+      context.framebuffer = render_pass.framebuffer.framebuffer;
+      context.pass = render_pass.framebuffer.pass;
+      RenderAPI::CmdBeginRenderPass(
+          context.cmd,
+          RenderAPI::BeginRenderPassInfo(
+              context.pass, context.framebuffer,
+              render_pass.framebuffer.render_area,
+              static_cast<uint32_t>(
+                  render_pass.framebuffer.clear_values.size()),
+              render_pass.framebuffer.clear_values.data(),
+              secondary ? RenderAPI::SubpassContents::kSecondaryCommandBuffers
+                        : RenderAPI::SubpassContents::kInline));
+      if (secondary) {
+        RenderAPI::CmdExecuteCommands(
+            context.cmd,
+            static_cast<uint32_t>(render_pass.secondary_cmds.size()),
+            render_pass.secondary_cmds.data());
+      } else {
+        for (auto& pass : render_pass.passes) {
+          pass->fn(&context, pass->scope);
+        }
+      }
+      RenderAPI::CmdEndRenderPass(context.cmd);
+    }
   }
-  passes_.emplace_back(std::move(pass));
+  RenderAPI::CmdEnd(context.cmd);
 }
 
-RenderAPI::Semaphore RenderGraph::ExecuteRenderPasses(
-    std::vector<RenderGraphNode>& nodes, RenderAPI::Semaphore semaphore) {
-  RenderAPI::Semaphore signal_semaphore = RenderAPI::kInvalidHandle;
-
-  RenderAPI::SubmitInfo submit_info;
+void RenderGraph::RecordJob(const RecordJobInfo& job) {
   RenderContext context;
-  size_t count = 0;
-  for (auto& node : nodes) {
-    if (node.render_cmd == RenderAPI::kInvalidHandle) {
-      continue;
-    }
-
-    context.cmd = node.render_cmd;
-    RenderAPI::CmdBegin(context.cmd);
+  context.cmd = job.cmd;
+  context.pass = job.framebuffer->pass;
+  context.framebuffer = job.framebuffer->framebuffer;
+  context.pipeline_cache = pipeline_cache_;
+  context.job = job.job;
+  context.job_count = job.pass->record_jobs;
+
+  RenderAPI::CommandBufferInheritanceInfo inheritance;
+  inheritance.pass = context.pass;
+  inheritance.framebuffer = context.framebuffer;
+  RenderAPI::CmdBegin(context.cmd, inheritance);
+  job.pass->fn(&context, job.pass->scope);
+  RenderAPI::CmdEnd(context.cmd);
+}
 
+void RenderGraph::PrepareJobs(std::vector<RenderGraphNode>& nodes) {
+  const uint32_t threads = workers_.GetThreadCount();
+  jobs_.clear();
+  for (auto& node : nodes) {
     for (auto& render_pass : node.render_passes) {
-      if (render_pass.framebuffer.pass != RenderAPI::kInvalidHandle &&
-          render_pass.framebuffer.framebuffer != RenderAPI::kInvalidHandle) {
-        context.framebuffer = render_pass.framebuffer.framebuffer;
-        context.pass = render_pass.framebuffer.pass;
-        RenderAPI::CmdBeginRenderPass(
-            context.cmd, RenderAPI::BeginRenderPassInfo(
-                             context.pass, context.framebuffer,
-                             render_pass.framebuffer.render_area,
-                             static_cast<uint32_t>(
-                                 render_pass.framebuffer.clear_values.size()),
-                             render_pass.framebuffer.clear_values.data()));
-        for (auto& pass : render_pass.passes) {
-          pass->fn(&context, pass->scope);
+      // Compiled nodes are reused across frames.
+      render_pass.secondary_cmds.clear();
+      const bool has_jobs =
+          std::any_of(render_pass.passes.cbegin(), render_pass.passes.cend(),
+                      [](const RenderGraphPass* pass) {
+                        return pass->record_jobs > 1;
+                      });
+      if (!has_jobs ||
+          render_pass.framebuffer.pass == RenderAPI::kInvalidHandle ||
+          render_pass.framebuffer.framebuffer == RenderAPI::kInvalidHandle) {
+        continue;
+      }
+
+      // Every pass sharing the render pass has to go through secondary
+      // command buffers, the ones without jobs are a single job.
+      for (auto pass : render_pass.passes) {
+        for (uint32_t job = 0; job < pass->record_jobs; ++job) {
+          const RenderAPI::CommandBuffer cmd = cache_.AllocateCommand(
+              static_cast<uint32_t>(jobs_.size() % threads),
+              RenderAPI::CommandBufferLevel::kSecondary);
+          render_pass.secondary_cmds.emplace_back(cmd);
+          jobs_.push_back({pass, &render_pass.framebuffer, cmd, job});
         }
-        RenderAPI::CmdEndRenderPass(context.cmd);
       }
     }
-    RenderAPI::CmdEnd(context.cmd);
+  }
+}
 
-    // If this is the first node, add the wait semaphore.
-    if (semaphore != RenderAPI::kInvalidHandle) {
-      node.wait_semaphores.emplace_back(semaphore);
-      semaphore = RenderAPI::kInvalidHandle;
-    }
+RenderAPI::Semaphore RenderGraph::ExecuteRenderPasses(
+    std::vector<RenderGraphNode>& nodes, RenderAPI::Semaphore semaphore) {
+  // Node i is recorded by worker i % threads, and so are the jobs. The command
+  // buffers come from the pool of their worker and are allocated up front, so
+  // the workers only record.
+  const uint32_t threads = workers_.GetThreadCount();
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    nodes[i].render_cmd =
+        cache_.AllocateCommand(static_cast<uint32_t>(i % threads));
+  }
 
-    // If this is the last pass, add a fence and semaphore.
-    ++count;
-    RenderAPI::Fence fence = RenderAPI::kInvalidHandle;
-    if (count == nodes.size()) {
-      fence = backbuffer_fences_[current_frame_];
-      signal_semaphore = cache_.AllocateSemaphore();
-      node.signal_semaphores.emplace_back(signal_semaphore);
+  // Jobs are recorded first, the nodes execute them.
+  PrepareJobs(nodes);
+  if (!jobs_.empty()) {
+    workers_.Run([this, threads](uint32_t worker) {
+      for (size_t i = worker; i < jobs_.size(); i += threads) {
+        RecordJob(jobs_[i]);
+      }
+    });
+  }
+
+  workers_.Run([this, &nodes, threads](uint32_t worker) {
+    RenderContext context;
+    context.pipeline_cache = pipeline_cache_;
+    for (size_t i = worker; i < nodes.size(); i += threads) {
+      RecordNode(nodes[i], context);
     }
+  });
 
-    // Submit the pass.
-    submit_info.signal_semaphores = node.signal_semaphores.data();
-    submit_info.signal_semaphores_count = node.signal_semaphores.size();
-    submit_info.wait_semaphores = node.wait_semaphores.data();
-    submit_info.wait_semaphores_count = node.wait_semaphores.size();
-    submit_info.command_buffers = &context.cmd;
-    submit_info.command_buffers_count = 1;
-    RenderAPI::QueueSubmit(device_, submit_info, fence);
+  // Submission keeps the node order regardless of which worker recorded them.
+  submit_cmds_.clear();
+  for (const auto& node : nodes) {
+    submit_cmds_.emplace_back(node.render_cmd);
+  }
+  if (submit_cmds_.empty()) {
+    return RenderAPI::kInvalidHandle;
+  }
+
+  // Nodes are ordered by the barriers recorded in them, so the frame only
+  // needs two batches: the nodes before the first use of the backbuffer don't
+  // wait on the acquired image, the rest do and signal the present semaphore.
+  uint32_t backbuffer_node = backbuffer_node_;
+  if (backbuffer_node == RenderGraphBuilder::kNotUsed ||
+      semaphore == RenderAPI::kInvalidHandle) {
+    backbuffer_node = 0;
+  }
+  backbuffer_node = std::min(backbuffer_node,
+                             static_cast<uint32_t>(submit_cmds_.size()) - 1);
+
+  const RenderAPI::PipelineStageFlags wait_stage =
+      RenderAPI::PipelineStageFlagBits::kColorAttachmentOutputBit;
+  const RenderAPI::Semaphore signal_semaphore = cache_.AllocateSemaphore();
+  RenderAPI::SubmitInfo submits[2];
+  uint32_t num_submits = 0;
+  if (backbuffer_node > 0) {
+    RenderAPI::SubmitInfo& submit = submits[num_submits++];
+    submit.command_buffers = submit_cmds_.data();
+    submit.command_buffers_count = backbuffer_node;
   }
+
+  RenderAPI::SubmitInfo& submit = submits[num_submits++];
+  if (semaphore != RenderAPI::kInvalidHandle) {
+    submit.wait_semaphores = &semaphore;
+    submit.wait_semaphores_count = 1;
+    submit.wait_stages = &wait_stage;
+  }
+  submit.command_buffers = submit_cmds_.data() + backbuffer_node;
+  submit.command_buffers_count =
+      static_cast<uint32_t>(submit_cmds_.size()) - backbuffer_node;
+  submit.signal_semaphores = &signal_semaphore;
+  submit.signal_semaphores_count = 1;
+
+  RenderAPI::QueueSubmit(device_, submits, num_submits,
+                         backbuffer_fences_[current_frame_]);
   return signal_semaphore;
 }
 
 RenderAPI::SwapChain RenderGraph::GetSwapChain() const { return swapchain_; }
 
+uint32_t RenderGraph::GetMaxFramesInFlight() const {
+  return max_frames_in_flight;
+}
+
+void RenderGraph::SetPipelineCache(RenderAPI::PipelineCache cache) {
+  pipeline_cache_ = cache;
+}
+
+RenderAPI::PipelineCache RenderGraph::GetPipelineCache() const {
+  return pipeline_cache_;
+}
+
+void RenderGraph::SetRecordingThreads(uint32_t count) {
+  workers_.SetThreadCount(count);
+}
+
+uint32_t RenderGraph::GetRecordingThreads() const {
+  return workers_.GetThreadCount();
+}
+
+const RenderGraphMemoryStats& RenderGraph::GetTransientMemoryStats() const {
+  return cache_.GetMemoryStats();
+}
+
+void RenderGraph::SetCachePolicy(const RenderGraphCachePolicy& policy) {
+  cache_.SetPolicy(policy);
+}
+
+const RenderGraphCacheStats& RenderGraph::GetCacheStats() const {
+  return cache_.GetStats();
+}
+
+const RenderGraphCompileStats& RenderGraph::GetCompileStats() const {
+  return compile_stats_;
+}
+
 void RenderGraph::AcquireBackbuffer() {
   // Prepare the next swapchain frame buffer for rendering.
   uint32_t image_index;
@@ -227,18 +419,16 @@ void RenderGraph::DestroySyncObjects() {
 
 RenderGraphResource RenderGraph::ImportTexture(RenderGraphTextureDesc desc,
                                                RenderAPI::ImageView texture) {
-  RenderGraphBuilder::RenderGraphTextureResource resource;
+  auto handle = builder_.handles_.Create();
+  auto& resource = builder_.CreateTexture(handle, std::move(desc));
   resource.transient = false;
-  resource.desc = std::move(desc);
   resource.texture = texture;
-  auto handle = builder_.handles_.Create();
-  builder_.textures_[handle] = std::move(resource);
   return handle;
 }
 
 void RenderGraph::MoveSubresource(RenderGraphResource from,
                                   RenderGraphResource to) {
-  builder_.aliases_[from] = to;
+  builder_.Alias(from, to);
 }
 
 const RenderGraphTextureDesc& RenderGraph::GetSwapChainDescription() const {
@@ -246,7 +436,9 @@ const RenderGraphTextureDesc& RenderGraph::GetSwapChainDescription() const {
 }
 
 RenderAPI::ImageView Scope::GetTexture(RenderGraphResource resource) const {
-  const auto& it = textures_.find(resource);
-  assert(it != textures_.cend());
-  return it->second;
+  assert(textures_ && "Scope used outside of a render graph!");
+  const size_t index = Generational::Manager::Index(resource);
+  assert(index < textures_->size() &&
+         (*textures_)[index] != RenderAPI::kInvalidHandle);
+  return (*textures_)[index];
 }
\ No newline at end of file
@@ -3,10 +3,13 @@
 #include <RenderAPI/RenderAPI.h>
 #include <cstdint>
 #include <memory>
-#include <string>
+#include <string_view>
+#include <utility>
+#include "render_graph_arena.h"
 #include "render_graph_builder.h"
 #include "render_graph_cache.h"
 #include "render_graph_pass.h"
+#include "render_graph_workers.h"
 
 struct RenderGraphPass;
 class RenderGraph {
@@ -15,13 +18,28 @@ class RenderGraph {
   ~RenderGraph();
 
   void BuildSwapChain(uint32_t width, uint32_t height);
+  // Frames the GPU may be working on at once, known once the swapchain is
+  // built. Per frame data must be buffered this many times.
+  uint32_t GetMaxFramesInFlight() const;
   void Destroy();
 
   void BeginFrame();
   void Render();
 
-  void AddPass(const std::string& name, RenderGraphSetupFn setup_fn,
-               RenderGraphRenderFn render_fn);
+  // setup_fn(RenderGraphBuilder&) declares the pass's resources and is called
+  // right away. render_fn(RenderContext*, const Scope&) records the pass, it
+  // and the name are kept in a frame arena so adding passes doesn't allocate.
+  template <typename SetupFn, typename RenderFn>
+  void AddPass(std::string_view name, SetupFn&& setup_fn,
+               RenderFn&& render_fn) {
+    builder_.SetCurrentPass(passes_.size());
+    setup_fn(builder_);
+
+    RenderGraphPass pass;
+    pass.name = arena_.CopyString(name);
+    pass.fn = RenderGraphRenderFn(arena_, std::forward<RenderFn>(render_fn));
+    passes_.emplace_back(std::move(pass));
+  }
 
   // Resources.
   RenderGraphResource ImportTexture(RenderGraphTextureDesc desc,
@@ -33,13 +51,35 @@ class RenderGraph {
   RenderGraphResource GetBackbufferResource() const;
   const RenderGraphTextureDesc& GetSwapChainDescription() const;
 
+  // Pipeline cache handed to passes through the RenderContext.
+  void SetPipelineCache(RenderAPI::PipelineCache cache);
+  RenderAPI::PipelineCache GetPipelineCache() const;
+
+  // Number of threads recording the nodes, including the thread calling
+  // Render(). With more than one thread the pass render functions of
+  // different nodes run concurrently and must be thread-safe.
+  void SetRecordingThreads(uint32_t count);
+  uint32_t GetRecordingThreads() const;
+
+  // Transient memory of the last rendered frame, aliased versus dedicated.
+  const RenderGraphMemoryStats& GetTransientMemoryStats() const;
+
+  // Transient resource eviction.
+  void SetCachePolicy(const RenderGraphCachePolicy& policy);
+  const RenderGraphCacheStats& GetCacheStats() const;
+
+  // Frames declaring the same passes and resources as a recent frame reuse its
+  // compiled nodes and transients instead of building the graph again.
+  const RenderGraphCompileStats& GetCompileStats() const;
+
  private:
   RenderAPI::Device device_;
   RenderAPI::SwapChain swapchain_ = RenderAPI::kInvalidHandle;
-  RenderAPI::CommandPool command_pool_ = RenderAPI::kInvalidHandle;
+  RenderAPI::PipelineCache pipeline_cache_ = RenderAPI::kInvalidHandle;
 
   RenderGraphBuilder builder_;
   RenderGraphCache cache_;
+  RenderGraphWorkers workers_;
 
   // Current frame and how many frames are allowed to be drawn at the same time.
   uint32_t current_frame_ = 0;
@@ -59,9 +99,47 @@ class RenderGraph {
   void AcquireBackbuffer();
   void DestroySwapChain();
 
-  // Passes.
+  // Passes, their names and render functions live in the arena. The functions
+  // only run in Render(), the arena is recycled when the next frame begins.
+  RenderGraphArena arena_;
   std::vector<RenderGraphPass> passes_;
-  std::vector<RenderGraphNode> Compile();
+  std::vector<RenderAPI::CommandBuffer> submit_cmds_;
+  std::vector<RenderGraphNode>& Compile();
+
+  // Compiled graphs, most recently used first. The backbuffer is part of the
+  // key, so one is kept per swapchain image, plus one.
+  struct CompiledGraph {
+    uint64_t hash;
+    // See RenderGraphBuilder::ComputeKey, compared on a hash match.
+    std::vector<uint64_t> key;
+    std::vector<RenderGraphNode> nodes;
+    // Index in passes_ of every pass of the nodes, in order.
+    std::vector<size_t> node_passes;
+    // Views of the textures for the scopes, by resource index.
+    std::vector<RenderAPI::ImageView> textures;
+    // Render target of every node, by resource index.
+    std::vector<size_t> node_targets;
+    uint32_t backbuffer_node;
+    RenderGraphTransients transients;
+  };
+  std::vector<CompiledGraph> compiled_graphs_;
+  // Key of the current frame, kept across frames.
+  std::vector<uint64_t> graph_key_;
+  RenderGraphCompileStats compile_stats_;
+  // First node using the backbuffer in the current frame.
+  uint32_t backbuffer_node_ = RenderGraphBuilder::kNotUsed;
+  void RecordNode(RenderGraphNode& node, RenderContext& context);
+
+  // Passes recording in jobs.
+  struct RecordJobInfo {
+    RenderGraphPass* pass;
+    const RenderGraphFramebuffer* framebuffer;
+    RenderAPI::CommandBuffer cmd;
+    uint32_t job;
+  };
+  std::vector<RecordJobInfo> jobs_;
+  void PrepareJobs(std::vector<RenderGraphNode>& nodes);
+  void RecordJob(const RecordJobInfo& job);
   RenderAPI::Semaphore ExecuteRenderPasses(std::vector<RenderGraphNode>& nodes,
                                            RenderAPI::Semaphore semaphore);
 };
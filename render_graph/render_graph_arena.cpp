@@ -0,0 +1,58 @@
+#include "render_graph_arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+RenderGraphArena::RenderGraphArena(size_t block_size)
+    : block_size_(block_size) {}
+
+RenderGraphArena::~RenderGraphArena() {
+  for (const auto& block : blocks_) {
+    ::operator delete(block.data);
+  }
+}
+
+void* RenderGraphArena::Allocate(size_t size, size_t alignment) {
+  assert(alignment <= alignof(std::max_align_t) &&
+         "Unsupported arena alignment!");
+  while (current_block_ < blocks_.size()) {
+    const Block& block = blocks_[current_block_];
+    const size_t offset = (offset_ + alignment - 1) & ~(alignment - 1);
+    if (offset + size <= block.size) {
+      offset_ = offset + size;
+      return block.data + offset;
+    }
+    ++current_block_;
+    offset_ = 0;
+  }
+
+  // Out of blocks, add one big enough for the allocation.
+  const size_t block_size = std::max(block_size_, size);
+  blocks_.push_back(
+      {static_cast<uint8_t*>(::operator new(block_size)), block_size});
+  current_block_ = blocks_.size() - 1;
+  offset_ = size;
+  return blocks_.back().data;
+}
+
+std::string_view RenderGraphArena::CopyString(std::string_view string) {
+  if (string.empty()) {
+    return {};
+  }
+  char* data = static_cast<char*>(Allocate(string.size(), alignof(char)));
+  memcpy(data, string.data(), string.size());
+  return std::string_view(data, string.size());
+}
+
+void RenderGraphArena::Reset() {
+  current_block_ = 0;
+  offset_ = 0;
+}
+
+size_t RenderGraphArena::GetCapacity() const {
+  size_t capacity = 0;
+  for (const auto& block : blocks_) {
+    capacity += block.size;
+  }
+  return capacity;
+}
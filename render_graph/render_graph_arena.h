@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Linear allocator for memory living until the end of the frame. Allocations
+// are bumped from blocks kept across frames, so once the blocks fit a frame
+// allocating is free of heap allocations. Destructors aren't called.
+class RenderGraphArena {
+ public:
+  explicit RenderGraphArena(size_t block_size = 64 * 1024);
+  ~RenderGraphArena();
+  RenderGraphArena(const RenderGraphArena&) = delete;
+  RenderGraphArena& operator=(const RenderGraphArena&) = delete;
+
+  void* Allocate(size_t size, size_t alignment);
+
+  template <typename T, typename... Args>
+  T* New(Args&&... args) {
+    return new (Allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  std::string_view CopyString(std::string_view string);
+
+  // Invalidates everything allocated, keeping the blocks.
+  void Reset();
+
+  size_t GetCapacity() const;
+
+ private:
+  struct Block {
+    uint8_t* data;
+    size_t size;
+  };
+  std::vector<Block> blocks_;
+  size_t block_size_;
+  size_t current_block_ = 0;
+  size_t offset_ = 0;
+};
+
+// Move-only callable whose target lives in a RenderGraphArena, so closures of
+// any size are stored without allocating. The target is destroyed with the
+// function, the arena must outlive it.
+template <typename Signature>
+class RenderGraphFunction;
+
+template <typename R, typename... Args>
+class RenderGraphFunction<R(Args...)> {
+ public:
+  RenderGraphFunction() = default;
+
+  template <typename Fn>
+  RenderGraphFunction(RenderGraphArena& arena, Fn&& fn) {
+    using Target = std::decay_t<Fn>;
+    target_ = arena.New<Target>(std::forward<Fn>(fn));
+    invoke_ = [](void* target, Args... args) -> R {
+      return (*static_cast<Target*>(target))(std::forward<Args>(args)...);
+    };
+    if (!std::is_trivially_destructible_v<Target>) {
+      destroy_ = [](void* target) { static_cast<Target*>(target)->~Target(); };
+    }
+  }
+
+  RenderGraphFunction(RenderGraphFunction&& other) noexcept { Swap(other); }
+  RenderGraphFunction& operator=(RenderGraphFunction&& other) noexcept {
+    RenderGraphFunction(std::move(other)).Swap(*this);
+    return *this;
+  }
+  RenderGraphFunction(const RenderGraphFunction&) = delete;
+  RenderGraphFunction& operator=(const RenderGraphFunction&) = delete;
+
+  ~RenderGraphFunction() {
+    if (destroy_) {
+      destroy_(target_);
+    }
+  }
+
+  R operator()(Args... args) const {
+    assert(invoke_ && "Calling an empty function!");
+    return invoke_(target_, std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const { return invoke_ != nullptr; }
+
+ private:
+  void* target_ = nullptr;
+  R (*invoke_)(void*, Args...) = nullptr;
+  void (*destroy_)(void*) = nullptr;
+
+  void Swap(RenderGraphFunction& other) {
+    std::swap(target_, other.target_);
+    std::swap(invoke_, other.invoke_);
+    std::swap(destroy_, other.destroy_);
+  }
+};
@@ -1,10 +1,95 @@
 #include "render_graph_builder.h"
 
+#include <algorithm>
 #include <cassert>
+#include <functional>
+
+namespace {
+constexpr RenderAPI::PipelineStageFlags kShaderReadStages =
+    RenderAPI::PipelineStageFlagBits::kVertexShaderBit |
+    RenderAPI::PipelineStageFlagBits::kFragmentShaderBit;
+
+// How a pass touches a texture it renders to.
+struct AttachmentAccess {
+  RenderAPI::PipelineStageFlags stages;
+  RenderAPI::AccessFlags read_access;
+  RenderAPI::AccessFlags write_access;
+};
+
+AttachmentAccess GetAttachmentAccess(bool depth) {
+  if (depth) {
+    return {RenderAPI::PipelineStageFlagBits::kEarlyFragmentTestsBit |
+                RenderAPI::PipelineStageFlagBits::kLateFragmentTestsBit,
+            RenderAPI::AccessFlagBits::kDepthStencilAttachmentReadBit,
+            RenderAPI::AccessFlagBits::kDepthStencilAttachmentWriteBit};
+  }
+  return {RenderAPI::PipelineStageFlagBits::kColorAttachmentOutputBit,
+          RenderAPI::AccessFlagBits::kColorAttachmentReadBit,
+          RenderAPI::AccessFlagBits::kColorAttachmentWriteBit};
+}
+
+// Counting sort of (key, value) pairs by key, keeping their order: the values
+// of key k end up in values[offsets[k], offsets[k + 1]).
+void GroupByKey(
+    const std::vector<std::pair<size_t, RenderGraphPassHandle>>& pairs,
+    size_t num_keys, std::vector<uint32_t>& offsets,
+    std::vector<RenderGraphPassHandle>& values) {
+  offsets.assign(num_keys + 1, 0);
+  for (const auto& it : pairs) {
+    ++offsets[it.first + 1];
+  }
+  for (size_t i = 0; i < num_keys; ++i) {
+    offsets[i + 1] += offsets[i];
+  }
+  values.resize(pairs.size());
+  for (const auto& it : pairs) {
+    values[offsets[it.first]++] = it.second;
+  }
+  for (size_t i = num_keys; i > 0; --i) {
+    offsets[i] = offsets[i - 1];
+  }
+  offsets[0] = 0;
+}
+}  // namespace
 
 RenderGraphBuilder::RenderGraphBuilder(RenderGraphCache* cache)
     : cache_(cache) {}
 
+size_t RenderGraphBuilder::ResourceIndex(RenderGraphResource handle) {
+  return static_cast<size_t>(Generational::Manager::Index(handle));
+}
+
+void RenderGraphBuilder::AddResource(RenderGraphResource handle) {
+  const size_t index = ResourceIndex(handle);
+  if (index < num_resources_) {
+    return;
+  }
+  num_resources_ = index + 1;
+  if (textures_.size() < num_resources_) {
+    textures_.resize(num_resources_);
+    framebuffers_.resize(num_resources_);
+    aliases_.resize(num_resources_, Generational::kInvalidHandle);
+  }
+}
+
+RenderGraphBuilder::RenderGraphTextureResource* RenderGraphBuilder::FindTexture(
+    RenderGraphResource handle) {
+  const size_t index = ResourceIndex(handle);
+  if (index >= num_resources_ || textures_[index].handle != handle) {
+    return nullptr;
+  }
+  return &textures_[index];
+}
+
+RenderGraphBuilder::RenderGraphFramebufferResource*
+RenderGraphBuilder::FindFramebuffer(RenderGraphResource handle) {
+  const size_t index = ResourceIndex(handle);
+  if (index >= num_resources_ || framebuffers_[index].handle != handle) {
+    return nullptr;
+  }
+  return &framebuffers_[index];
+}
+
 const RenderGraphResourceTextures& RenderGraphBuilder::UseRenderTarget(
     RenderGraphResource resource) {
   if (debug_current_pass_render_targets_++ > 0) {
@@ -12,237 +97,619 @@ const RenderGraphResourceTextures& RenderGraphBuilder::UseRenderTarget(
   }
 
   // If the resource is a texture.
-  if (auto& it = textures_.find(resource); it != textures_.end()) {
+  if (const RenderGraphTextureResource* texture = FindTexture(resource)) {
     // Create a render target for the texture.
-    RenderGraphFramebufferResource rt;
-    rt.desc = {{it->second.desc}};
-    rt.textures.textures.emplace_back(resource);
+    const RenderGraphTextureDesc desc = texture->desc;
+    const RenderGraphResource texture_handle = resource;
 
     // Forward the frame target resource handle instead.
     resource = handles_.Create();
-    framebuffers_[resource] = std::move(rt);
+    AddResource(resource);
+    RenderGraphFramebufferResource& rt = framebuffers_[ResourceIndex(resource)];
+    rt.handle = resource;
+    rt.desc.textures.assign(1, desc);
+    rt.textures.textures.assign(1, texture_handle);
   }
 
-  render_targets_[resource].emplace_back(current_pass_);
-  auto& it = framebuffers_.find(resource);
-  assert(it != framebuffers_.cend() && "Invalid render target!");
-  ++it->second.ref_count;
-  for (auto texture : it->second.textures.textures) {
+  RenderGraphFramebufferResource* framebuffer = FindFramebuffer(resource);
+  assert(framebuffer && "Invalid render target!");
+  if (pass_targets_.size() <= current_pass_) {
+    pass_targets_.resize(current_pass_ + 1, Generational::kInvalidHandle);
+  }
+  pass_targets_[current_pass_] = resource;
+  ++framebuffer->ref_count;
+  for (auto texture : framebuffer->textures.textures) {
     Write(texture);
   }
-  return it->second.textures;
+  return framebuffer->textures;
 }
 
 const RenderGraphResourceTextures& RenderGraphBuilder::CreateRenderTarget(
     RenderGraphTextureDesc info) {
-  RenderGraphFramebufferDesc framebuffer_info = {{info}};
-  return CreateRenderTarget(framebuffer_info);
+  return CreateRenderTarget(&info, 1);
 }
 
 const RenderGraphResourceTextures& RenderGraphBuilder::CreateRenderTarget(
     RenderGraphFramebufferDesc info) {
-  auto handle = handles_.Create();
+  return CreateRenderTarget(info.textures.data(), info.textures.size());
+}
 
-  RenderGraphFramebufferResource resource;
-  for (const auto& it : info.textures) {
-    resource.textures.textures.emplace_back(CreateTexture(it));
+const RenderGraphResourceTextures& RenderGraphBuilder::CreateRenderTarget(
+    const RenderGraphTextureDesc* descs, size_t count) {
+  auto handle = handles_.Create();
+  AddResource(handle);
+
+  RenderGraphResource last_handle = handle;
+  {
+    auto& textures = framebuffers_[ResourceIndex(handle)].textures.textures;
+    textures.resize(count);
+    handles_.CreateN(textures.data(), textures.size());
+    for (auto texture : textures) {
+      if (ResourceIndex(texture) > ResourceIndex(last_handle)) {
+        last_handle = texture;
+      }
+    }
   }
-  resource.desc = std::move(info);
-  framebuffers_[handle] = std::move(resource);
+  // Grows the storage once for every texture, references are taken after.
+  AddResource(last_handle);
+
+  // Assigned in place to keep the storage of the slot from previous frames.
+  RenderGraphFramebufferResource& framebuffer =
+      framebuffers_[ResourceIndex(handle)];
+  for (size_t i = 0; i < count; ++i) {
+    CreateTexture(framebuffer.textures.textures[i], descs[i]);
+  }
+  framebuffer.handle = handle;
+  framebuffer.desc.textures.assign(descs, descs + count);
 
   return UseRenderTarget(handle);
 }
 
-RenderGraphResource RenderGraphBuilder::CreateTexture(
-    RenderGraphTextureDesc info) {
-  auto handle = handles_.Create();
-
-  RenderGraphTextureResource resource;
-  resource.desc = std::move(info);
-  textures_[handle] = std::move(resource);
-  return handle;
+RenderGraphBuilder::RenderGraphTextureResource&
+RenderGraphBuilder::CreateTexture(RenderGraphResource handle,
+                                  RenderGraphTextureDesc info) {
+  AddResource(handle);
+  RenderGraphTextureResource& texture = textures_[ResourceIndex(handle)];
+  texture = RenderGraphTextureResource();
+  texture.handle = handle;
+  texture.desc = std::move(info);
+  return texture;
 }
 
 void RenderGraphBuilder::Write(RenderGraphResource resource) {
-  writes_[resource].emplace_back(current_pass_);
+  assert(ResourceIndex(resource) < num_resources_ && "Invalid resource!");
+  uses_.push_back({resource, current_pass_, true});
 }
 void RenderGraphBuilder::Read(RenderGraphResource resource) {
-  reads_[resource].emplace_back(current_pass_);
+  assert(ResourceIndex(resource) < num_resources_ && "Invalid resource!");
+  uses_.push_back({resource, current_pass_, false});
 }
 
 std::vector<RenderGraphNode> RenderGraphBuilder::Build(
     std::vector<RenderGraphPass>& passes) {
-  // Handle aliasing.
-  for (const auto& alias : aliases_) {
-    const auto& writes = writes_.find(alias.first);
-    if (writes != writes_.cend()) {
-      auto& new_resource = writes_[GetAlised(alias.first)];
-      new_resource.insert(new_resource.begin(), writes->second.begin(),
-                          writes->second.end());
-      writes_.erase(writes);
-    }
-
-    const auto& reads = reads_.find(alias.first);
-    if (reads != reads_.cend()) {
-      auto& new_resource = reads_[GetAlised(alias.first)];
-      new_resource.insert(new_resource.begin(), reads->second.begin(),
-                          reads->second.end());
-      reads_.erase(reads);
-    }
+  for (const auto& it : record_jobs_) {
+    passes[it.first].record_jobs = it.second;
+  }
 
-    const auto& render_targets = render_targets_.find(alias.first);
-    if (render_targets != render_targets_.cend()) {
-      auto& new_resource = render_targets_[GetAlised(alias.first)];
-      new_resource.insert(new_resource.begin(), render_targets->second.begin(),
-                          render_targets->second.end());
-      render_targets_.erase(render_targets);
-    }
+  // TODO:
+  // 1. Add support for non render pass.
+  // 2. Add support for read only passes(?).
+  const size_t num_passes = passes.size();
+  const size_t num_resources = num_resources_;
+  std::vector<RenderGraphNode> nodes;
 
-    // Erase the resources to avoid creating data for them.
-    textures_.erase(alias.first);
-    framebuffers_.erase(alias.first);
+  // Textures that weren't moved to another resource.
+  auto is_texture = [this](size_t resource) {
+    return textures_[resource].handle != Generational::kInvalidHandle &&
+           aliases_[resource] == Generational::kInvalidHandle;
+  };
+
+  // Group the accesses by resource, with aliases resolved. The accesses of
+  // resource r are accesses_[access_offsets_[r], access_offsets_[r + 1]).
+  access_offsets_.assign(num_resources + 1, 0);
+  for (const auto& use : uses_) {
+    ++access_offsets_[ResourceIndex(GetAlised(use.resource)) + 1];
   }
-
-  // Create the resources.
-  for (auto& it : textures_) {
-    auto& texture = it.second;
-    if (texture.transient) {
-      texture.texture = cache_->CreateTransientTexture(texture.desc);
+  for (size_t i = 0; i < num_resources; ++i) {
+    access_offsets_[i + 1] += access_offsets_[i];
+  }
+  accesses_.resize(uses_.size());
+  for (const auto& use : uses_) {
+    const size_t resource = ResourceIndex(GetAlised(use.resource));
+    accesses_[access_offsets_[resource]++] = {use.pass, use.write};
+  }
+  for (size_t i = num_resources; i > 0; --i) {
+    access_offsets_[i] = access_offsets_[i - 1];
+  }
+  access_offsets_[0] = 0;
+  auto accesses_begin = [this](size_t resource) {
+    return accesses_.begin() + access_offsets_[resource];
+  };
+  auto accesses_end = [this](size_t resource) {
+    return accesses_.begin() + access_offsets_[resource + 1];
+  };
+
+  // Build the dependency DAG. A resource is accessed in the order the passes
+  // were added, writes of a pass before its reads: reads depend on the last
+  // write before them and writes on every access since the last write.
+  //
+  // Passes whose output a pass consumes (used for culling), and every pass that
+  // has to run after a pass (used for ordering).
+  static constexpr RenderGraphPassHandle kNoPass = ~RenderGraphPassHandle(0);
+  producer_edges_.clear();
+  successor_edges_.clear();
+  std::vector<RenderGraphPassHandle> reads_since_write;
+  for (size_t resource = 0; resource < num_resources; ++resource) {
+    std::sort(accesses_begin(resource), accesses_end(resource),
+              [](const Access& a, const Access& b) {
+                return a.pass != b.pass ? a.pass < b.pass : a.write > b.write;
+              });
+    RenderGraphPassHandle last_write = kNoPass;
+    reads_since_write.clear();
+    for (auto it = accesses_begin(resource); it != accesses_end(resource);
+         ++it) {
+      const Access& access = *it;
+      if (last_write != kNoPass && last_write != access.pass) {
+        producer_edges_.emplace_back(access.pass, last_write);
+        successor_edges_.emplace_back(last_write, access.pass);
+      }
+      if (!access.write) {
+        reads_since_write.emplace_back(access.pass);
+        continue;
+      }
+      for (auto reader : reads_since_write) {
+        if (reader != access.pass) {
+          successor_edges_.emplace_back(reader, access.pass);
+        }
+      }
+      reads_since_write.clear();
+      last_write = access.pass;
     }
   }
-
-  for (auto& it : framebuffers_) {
-    auto& framebuffer = it.second;
-    for (auto& texture_handle : framebuffer.textures.textures) {
-      texture_handle = GetAlised(texture_handle);
+  GroupByKey(producer_edges_, num_passes, producer_offsets_, producers_);
+  GroupByKey(successor_edges_, num_passes, successor_offsets_, successors_);
+
+  // Cull transitively from the sinks: passes with side effects and passes
+  // writing to imported resources, which outlive the graph.
+  std::vector<bool> live(num_passes, false);
+  std::vector<RenderGraphPassHandle> stack = side_effects_;
+  for (size_t resource = 0; resource < num_resources; ++resource) {
+    if (!is_texture(resource) || textures_[resource].transient) {
+      continue;
     }
-
-    if (framebuffer.transient) {
-      std::vector<RenderAPI::ImageView> images;
-      images.reserve(framebuffer.textures.textures.size());
-      for (const auto& texture_handle : framebuffer.textures.textures) {
-        images.emplace_back(textures_[texture_handle].texture);
+    for (auto it = accesses_begin(resource); it != accesses_end(resource);
+         ++it) {
+      if (it->write) {
+        stack.emplace_back(it->pass);
       }
-      framebuffer.framebuffer =
-          cache_->CreateTransientFramebuffer(framebuffer.desc, images);
     }
   }
-
-  // TODO:
-  // 1. Optimize the culling algorithm.
-  // 2. Add proper semaphore generation according to dependencies.
-  // 3. Add support for non render pass.
-  // 4. Add support for read only passes(?).
-  std::vector<RenderGraphNode> nodes;
-
-  // Cull unused render passes. (This is very rough and needs optimizing 💩.)
-  std::vector<bool> culled(
-      passes.size(),
-      false);  // For later: Use a linear allocator or add it to the struct, or
-               // a better way to remove the nodes.
-
-  // Remove every reader who no one is writing to their resources.
-  for (const auto& readers : reads_) {
-    const auto& writers = writes_.find(readers.first);
-    if (writers == writes_.cend()) {
-      // No one is writing to these pass. Cull it.
-      for (auto reader : readers.second) {
-        culled[reader] = true;
+  for (auto pass : stack) {
+    live[pass] = true;
+  }
+  while (!stack.empty()) {
+    RenderGraphPassHandle pass = stack.back();
+    stack.pop_back();
+    for (uint32_t i = producer_offsets_[pass]; i < producer_offsets_[pass + 1];
+         ++i) {
+      const RenderGraphPassHandle producer = producers_[i];
+      if (!live[producer]) {
+        live[producer] = true;
+        stack.emplace_back(producer);
       }
     }
   }
 
-  // For every writer, add a reference count for each resource they write to.
-  for (const auto& writers : writes_) {
-    for (auto writer : writers.second) {
-      ++passes[writer].ref_count;
+  // The render target of every pass, passes without one aren't executed.
+  std::vector<RenderGraphResource> pass_targets(num_passes);
+  std::vector<bool> has_target(num_passes, false);
+  for (size_t pass = 0; pass < pass_targets_.size(); ++pass) {
+    if (pass_targets_[pass] != Generational::kInvalidHandle) {
+      pass_targets[pass] = GetAlised(pass_targets_[pass]);
+      has_target[pass] = true;
     }
   }
 
-  // Cull writers without readers.
-  for (const auto& writers : writes_) {
-    const auto& readers = reads_.find(writers.first);
-    if (readers == reads_.end()) {
-      // No one is data, reduce refence count of writers.
-      for (auto& writer : writers.second) {
-        if (--passes[writer].ref_count == 0) {
-          culled[writer] = true;
-        }
+  // Topological sort of the live passes. Among the ready passes, prefer one
+  // sharing the previous pass's render target so they merge into a node, then
+  // the one added first, which keeps the schedule stable. A ready pass is in
+  // both heaps, the one it wasn't scheduled from skips it later.
+  std::vector<uint32_t> in_degree(num_passes, 0);
+  for (size_t pass = 0; pass < num_passes; ++pass) {
+    if (!live[pass]) {
+      continue;
+    }
+    for (uint32_t i = successor_offsets_[pass];
+         i < successor_offsets_[pass + 1]; ++i) {
+      if (live[successors_[i]]) {
+        ++in_degree[successors_[i]];
+      }
+    }
+  }
+  ready_.clear();
+  if (target_ready_.size() < num_resources) {
+    target_ready_.resize(num_resources);
+  }
+  for (size_t i = 0; i < num_resources; ++i) {
+    target_ready_[i].clear();
+  }
+  const std::greater<RenderGraphPassHandle> later;
+  auto make_ready = [&](RenderGraphPassHandle pass) {
+    ready_.emplace_back(pass);
+    std::push_heap(ready_.begin(), ready_.end(), later);
+    if (has_target[pass]) {
+      auto& target_ready = target_ready_[ResourceIndex(pass_targets[pass])];
+      target_ready.emplace_back(pass);
+      std::push_heap(target_ready.begin(), target_ready.end(), later);
+    }
+  };
+  std::vector<bool> scheduled(num_passes, false);
+  auto pop_ready = [&](std::vector<RenderGraphPassHandle>& heap) {
+    while (!heap.empty()) {
+      std::pop_heap(heap.begin(), heap.end(), later);
+      const RenderGraphPassHandle pass = heap.back();
+      heap.pop_back();
+      if (!scheduled[pass]) {
+        return pass;
       }
     }
+    return kNoPass;
+  };
+  for (size_t pass = 0; pass < num_passes; ++pass) {
+    if (live[pass] && in_degree[pass] == 0) {
+      make_ready(pass);
+    }
   }
 
-  for (auto& render_target : render_targets_) {
-    RenderGraphNode node;
-    RenderGraphCombinedRenderPasses render_node;
-    render_node.framebuffer = framebuffers_[render_target.first].framebuffer;
-    for (auto& it : render_target.second) {
-      if (culled[it]) {
-        continue;
+  // Nodes execute in order, a pass runs at the index of its node.
+  static constexpr uint32_t kNotScheduled = ~0u;
+  std::vector<uint32_t> pass_order(num_passes, kNotScheduled);
+  node_targets_.clear();
+  RenderGraphPassHandle previous = kNoPass;
+  for (;;) {
+    RenderGraphPassHandle pass = kNoPass;
+    if (previous != kNoPass) {
+      pass = pop_ready(target_ready_[ResourceIndex(pass_targets[previous])]);
+    }
+    if (pass == kNoPass) {
+      pass = pop_ready(ready_);
+    }
+    if (pass == kNoPass) {
+      break;
+    }
+    scheduled[pass] = true;
+    for (uint32_t i = successor_offsets_[pass];
+         i < successor_offsets_[pass + 1]; ++i) {
+      const RenderGraphPassHandle successor = successors_[i];
+      if (live[successor] && --in_degree[successor] == 0) {
+        make_ready(successor);
       }
-      render_node.passes.emplace_back(&passes[it]);
     }
-    if (!render_node.passes.empty()) {
-      node.render_passes.emplace_back(std::move(render_node));
+
+    if (!has_target[pass]) {
+      continue;
+    }
+    const size_t target = ResourceIndex(pass_targets[pass]);
+    if (nodes.empty() || node_targets_.back() != target) {
+      RenderGraphNode node;
+      node.render_passes.emplace_back();
       nodes.emplace_back(std::move(node));
+      node_targets_.emplace_back(target);
     }
+    pass_order[pass] = static_cast<uint32_t>(nodes.size() - 1);
+    nodes.back().render_passes[0].passes.emplace_back(&passes[pass]);
+    previous = pass;
   }
 
-  // Create semaphores.
-  /*for (auto& readers : reads_) {
-    auto& writers = writes_.find(readers.first);
-    if (writers == writes_.end()) {
+  // Lifetime analysis: a transient texture is alive from the first to the last
+  // node using it, so textures with disjoint lifetimes can share memory.
+  struct TextureLifetime {
+    size_t resource;
+    uint32_t first_use = kNotScheduled;
+    uint32_t last_use = 0;
+  };
+  std::vector<TextureLifetime> allocations;
+  for (size_t resource = 0; resource < num_resources; ++resource) {
+    if (!is_texture(resource) || !textures_[resource].transient) {
       continue;
     }
-    for (auto reader : readers.second) {
-      if (culled[reader]) {
+    TextureLifetime lifetime;
+    lifetime.resource = resource;
+    for (auto it = accesses_begin(resource); it != accesses_end(resource);
+         ++it) {
+      if (pass_order[it->pass] == kNotScheduled) {
         continue;
       }
+      lifetime.first_use = std::min(lifetime.first_use, pass_order[it->pass]);
+      lifetime.last_use = std::max(lifetime.last_use, pass_order[it->pass]);
+    }
+    if (lifetime.first_use != kNotScheduled) {
+      allocations.emplace_back(lifetime);
+    }
+  }
 
-      for (auto writer : writers->second) {
-        if (writer == reader) {
-          continue;
-        }
-        RenderAPI::Semaphore semaphore = cache_->AllocateSemaphore();
-        passes[writer].signal_semaphores.emplace_back(semaphore);
-        passes[reader].wait_semaphores.emplace_back(semaphore);
+  // Create the textures that are used, largest first to pack the heaps
+  // tighter.
+  std::sort(allocations.begin(), allocations.end(),
+            [this](const TextureLifetime& a, const TextureLifetime& b) {
+              const auto& desc_a = textures_[a.resource].desc;
+              const auto& desc_b = textures_[b.resource].desc;
+              const uint64_t size_a =
+                  static_cast<uint64_t>(desc_a.width) * desc_a.height;
+              const uint64_t size_b =
+                  static_cast<uint64_t>(desc_b.width) * desc_b.height;
+              if (size_a != size_b) {
+                return size_a > size_b;
+              }
+              return a.resource < b.resource;
+            });
+  std::vector<RenderGraphMemoryRange> placements(allocations.size());
+  for (size_t i = 0; i < allocations.size(); ++i) {
+    auto& texture = textures_[allocations[i].resource];
+    texture.texture = cache_->CreateTransientTexture(
+        texture.desc, allocations[i].first_use, allocations[i].last_use,
+        &placements[i]);
+  }
+
+  // Create the framebuffers of the scheduled nodes. Attachments an earlier
+  // node rendered to, e.g. a render target split across nodes, load what it
+  // wrote instead of being cleared again.
+  std::vector<bool> rendered(num_resources, false);
+  std::vector<RenderAPI::ImageView> images;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    auto& framebuffer = framebuffers_[node_targets_[i]];
+    uint32_t load_mask = 0;
+    images.clear();
+    for (size_t j = 0; j < framebuffer.textures.textures.size(); ++j) {
+      auto& texture_handle = framebuffer.textures.textures[j];
+      texture_handle = GetAlised(texture_handle);
+      const size_t texture = ResourceIndex(texture_handle);
+      if (rendered[texture]) {
+        load_mask |= 1u << j;
       }
+      rendered[texture] = true;
+      images.emplace_back(textures_[texture].texture);
     }
-  }*/
-  // Create dumb semaphores for now (later optimize
-  // semaphores to be created for dependencies).
-  /*for (size_t i = 1; i < nodes.size(); ++i) {
-    RenderAPI::Semaphore semaphore = cache_->AllocateSemaphore();
-    nodes[i - 1].signal_semaphores.emplace_back(semaphore);
-    nodes[i].wait_semaphores.emplace_back(semaphore);
-  }*/
-
-  // Create the command buffers.
-  for (auto& it : nodes) {
-    it.render_cmd = cache_->AllocateCommand();
-  }
-
-  // Build scopes.
-  for (const auto& readers : reads_) {
-    for (auto reader : readers.second) {
-      if (culled[reader]) {
+
+    if (framebuffer.transient) {
+      framebuffer.framebuffer = cache_->CreateTransientFramebuffer(
+          framebuffer.desc, images, load_mask);
+    }
+    nodes[i].render_passes[0].framebuffer = framebuffer.framebuffer;
+  }
+  SetClearValues(node_targets_, nodes);
+
+  // Barriers. Every node runs on the graphics queue, so the dependencies
+  // between nodes only need barriers, recorded at the start of the consumer.
+  // Layout transitions are done by the render passes.
+  first_node_uses_.assign(num_resources, kNotUsed);
+  for (size_t resource = 0; resource < num_resources; ++resource) {
+    const bool depth =
+        is_texture(resource) &&
+        RenderAPI::IsDepthStencilFormat(textures_[resource].desc.format);
+    const AttachmentAccess attachment = GetAttachmentAccess(depth);
+
+    // The accesses in execution order.
+    ordered_accesses_.clear();
+    for (auto it = accesses_begin(resource); it != accesses_end(resource);
+         ++it) {
+      if (pass_order[it->pass] != kNotScheduled) {
+        ordered_accesses_.emplace_back(*it);
+      }
+    }
+    std::stable_sort(ordered_accesses_.begin(), ordered_accesses_.end(),
+                     [&pass_order](const Access& a, const Access& b) {
+                       return pass_order[a.pass] < pass_order[b.pass];
+                     });
+    if (!ordered_accesses_.empty()) {
+      first_node_uses_[resource] = pass_order[ordered_accesses_[0].pass];
+    }
+
+    uint32_t last_write = kNotScheduled;
+    reads_since_write_.clear();
+    for (const Access& access : ordered_accesses_) {
+      const uint32_t node = pass_order[access.pass];
+      RenderAPI::PipelineBarrier& barrier = nodes[node].barrier;
+      if (!access.write) {
+        if (last_write != kNotScheduled && last_write != node) {
+          barrier.src_stages |= attachment.stages;
+          barrier.src_access |= attachment.write_access;
+          barrier.dst_stages |= kShaderReadStages;
+          barrier.dst_access |= RenderAPI::AccessFlagBits::kShaderReadBit;
+        }
+        reads_since_write_.emplace_back(node);
         continue;
       }
-      passes[reader].scope.textures_[readers.first] =
-          textures_[readers.first].texture;
+
+      if (last_write != kNotScheduled && last_write != node) {
+        barrier.src_stages |= attachment.stages;
+        barrier.src_access |= attachment.write_access;
+        barrier.dst_stages |= attachment.stages;
+        barrier.dst_access |= attachment.read_access | attachment.write_access;
+      }
+      // Reads only need to finish before the write starts.
+      for (auto reader : reads_since_write_) {
+        if (reader != node) {
+          barrier.src_stages |= kShaderReadStages;
+          barrier.dst_stages |= attachment.stages;
+        }
+      }
+      reads_since_write_.clear();
+      last_write = node;
+    }
+  }
+
+  // Transients sharing memory must wait for every earlier occupant to be done
+  // with it. The placements are walked by offset in each heap, so only the
+  // ones overlapping in memory are compared, in node order since the textures
+  // are placed by size.
+  auto add_aliasing_barrier = [&](size_t earlier, size_t later) {
+    const AttachmentAccess earlier_access =
+        GetAttachmentAccess(RenderAPI::IsDepthStencilFormat(
+            textures_[allocations[earlier].resource].desc.format));
+    const AttachmentAccess later_access =
+        GetAttachmentAccess(RenderAPI::IsDepthStencilFormat(
+            textures_[allocations[later].resource].desc.format));
+    RenderAPI::PipelineBarrier& barrier =
+        nodes[placements[later].first_use].barrier;
+    barrier.src_stages |= earlier_access.stages | kShaderReadStages;
+    barrier.src_access |= earlier_access.write_access;
+    barrier.dst_stages |= later_access.stages;
+    barrier.dst_access |= later_access.write_access;
+  };
+  placement_order_.clear();
+  for (size_t i = 0; i < placements.size(); ++i) {
+    placement_order_.emplace_back(i);
+  }
+  std::sort(placement_order_.begin(), placement_order_.end(),
+            [&placements](size_t a, size_t b) {
+              const RenderGraphMemoryRange& range_a = placements[a];
+              const RenderGraphMemoryRange& range_b = placements[b];
+              return range_a.heap != range_b.heap
+                         ? range_a.heap < range_b.heap
+                         : range_a.offset < range_b.offset;
+            });
+  for (size_t i = 0; i < placement_order_.size(); ++i) {
+    const size_t a = placement_order_[i];
+    const RenderGraphMemoryRange& range_a = placements[a];
+    for (size_t j = i + 1; j < placement_order_.size(); ++j) {
+      const size_t b = placement_order_[j];
+      const RenderGraphMemoryRange& range_b = placements[b];
+      if (range_b.heap != range_a.heap ||
+          range_b.offset >= range_a.offset + range_a.size) {
+        break;
+      }
+      if (range_a.last_use < range_b.first_use) {
+        add_aliasing_barrier(a, b);
+      } else if (range_b.last_use < range_a.first_use) {
+        add_aliasing_barrier(b, a);
+      }
     }
   }
 
+  // Build scopes, shared by every pass. Moved textures resolve to the view of
+  // the resource they were moved to.
+  scope_textures_.assign(num_resources, RenderAPI::kInvalidHandle);
+  for (size_t resource = 0; resource < num_resources; ++resource) {
+    if (textures_[resource].handle != Generational::kInvalidHandle) {
+      scope_textures_[resource] =
+          textures_[ResourceIndex(GetAlised(textures_[resource].handle))]
+              .texture;
+    }
+  }
+  for (auto& pass : passes) {
+    pass.scope.textures_ = &scope_textures_;
+  }
+
   return nodes;
 }
 
+void RenderGraphBuilder::SetClearValues(
+    const std::vector<size_t>& node_targets,
+    std::vector<RenderGraphNode>& nodes) const {
+  assert(node_targets.size() == nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const auto& desc = framebuffers_[node_targets[i]].desc;
+    auto& clear_values = nodes[i].render_passes[0].framebuffer.clear_values;
+    clear_values.resize(desc.textures.size());
+    for (size_t j = 0; j < desc.textures.size(); ++j) {
+      clear_values[j] = desc.textures[j].clear_values;
+    }
+  }
+}
+
+uint64_t RenderGraphBuilder::ComputeKey(size_t num_passes,
+                                        std::vector<uint64_t>& key) const {
+  // Handles are handed out in the same order every frame, so they can be
+  // compared.
+  key.clear();
+  key.emplace_back(num_passes);
+  for (const auto& it : uses_) {
+    key.emplace_back(it.resource);
+    key.emplace_back(it.pass);
+    key.emplace_back(it.write);
+  }
+  for (auto target : pass_targets_) {
+    key.emplace_back(target);
+  }
+  for (const auto& it : record_jobs_) {
+    key.emplace_back(it.first);
+    key.emplace_back(it.second);
+  }
+  for (auto pass : side_effects_) {
+    key.emplace_back(pass);
+  }
+  auto add_desc = [&key](const RenderGraphTextureDesc& desc) {
+    key.emplace_back(static_cast<uint64_t>(desc.format));
+    key.emplace_back(desc.width);
+    key.emplace_back(desc.height);
+    key.emplace_back(static_cast<uint64_t>(desc.load_op));
+    key.emplace_back(static_cast<uint64_t>(desc.layout));
+  };
+  for (size_t i = 0; i < num_resources_; ++i) {
+    const RenderGraphFramebufferResource& framebuffer = framebuffers_[i];
+    key.emplace_back(framebuffer.handle);
+    key.emplace_back(framebuffer.desc.textures.size());
+    for (const auto& desc : framebuffer.desc.textures) {
+      add_desc(desc);
+    }
+    key.emplace_back(framebuffer.textures.textures.size());
+    for (auto texture : framebuffer.textures.textures) {
+      key.emplace_back(texture);
+    }
+    key.emplace_back(framebuffer.transient);
+
+    // Imported textures are compared by view, transients have none yet.
+    const RenderGraphTextureResource& texture = textures_[i];
+    key.emplace_back(texture.handle);
+    add_desc(texture.desc);
+    key.emplace_back(texture.transient);
+    key.emplace_back(texture.texture);
+
+    key.emplace_back(aliases_[i]);
+  }
+
+  uint64_t hash = key.size();
+  for (auto value : key) {
+    hash = HashCombine(hash, value);
+  }
+  return hash;
+}
+
+uint32_t RenderGraphBuilder::GetFirstNodeUse(
+    RenderGraphResource resource) const {
+  const size_t index = ResourceIndex(GetAlised(resource));
+  return index < first_node_uses_.size() ? first_node_uses_[index] : kNotUsed;
+}
+
+void RenderGraphBuilder::SideEffect() {
+  side_effects_.emplace_back(current_pass_);
+}
+
+void RenderGraphBuilder::RecordJobs(uint32_t count) {
+  assert(count > 0);
+  record_jobs_.emplace_back(current_pass_, count);
+}
+
 void RenderGraphBuilder::Reset() {
   handles_.Reset();
-  reads_.clear();
-  writes_.clear();
-  render_targets_.clear();
-  framebuffers_.clear();
-  textures_.clear();
+  // Keeps the storage of the resources for the next frame.
+  for (size_t i = 0; i < num_resources_; ++i) {
+    RenderGraphFramebufferResource& framebuffer = framebuffers_[i];
+    framebuffer.handle = Generational::kInvalidHandle;
+    framebuffer.desc.textures.clear();
+    framebuffer.textures.textures.clear();
+    framebuffer.transient = true;
+    framebuffer.ref_count = 0;
+    textures_[i] = RenderGraphTextureResource();
+    aliases_[i] = Generational::kInvalidHandle;
+  }
+  num_resources_ = 0;
+  uses_.clear();
+  pass_targets_.clear();
+  side_effects_.clear();
+  record_jobs_.clear();
+  first_node_uses_.clear();
 }
 
 void RenderGraphBuilder::SetCurrentPass(RenderGraphPassHandle pass) {
@@ -250,13 +717,19 @@ void RenderGraphBuilder::SetCurrentPass(RenderGraphPassHandle pass) {
   debug_current_pass_render_targets_ = 0;
 }
 
+void RenderGraphBuilder::Alias(RenderGraphResource from,
+                               RenderGraphResource to) {
+  assert(ResourceIndex(from) < num_resources_ && "Invalid resource!");
+  aliases_[ResourceIndex(from)] = to;
+}
+
 RenderGraphResource RenderGraphBuilder::GetAlised(
     RenderGraphResource handle) const {
-  std::unordered_map<RenderGraphResource, RenderGraphResource>::const_iterator
-      it = aliases_.find(handle);
-  while (it != aliases_.cend()) {
-    handle = it->second;
-    it = aliases_.find(handle);
+  size_t index = ResourceIndex(handle);
+  while (index < num_resources_ &&
+         aliases_[index] != Generational::kInvalidHandle) {
+    handle = aliases_[index];
+    index = ResourceIndex(handle);
   }
   return handle;
-}
\ No newline at end of file
+}
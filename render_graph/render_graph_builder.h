@@ -1,7 +1,6 @@
 #pragma once
 
-#include <map>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 #include "render_graph_cache.h"
 #include "render_graph_pass.h"
@@ -13,6 +12,7 @@ class RenderGraphBuilder {
  public:
   RenderGraphBuilder(RenderGraphCache* cache);
 
+  // The returned textures are valid until the next resource is created.
   const RenderGraphResourceTextures& UseRenderTarget(
       RenderGraphResource resource);
   const RenderGraphResourceTextures& CreateRenderTarget(
@@ -22,9 +22,25 @@ class RenderGraphBuilder {
 
   void Write(RenderGraphResource resource);
   void Read(RenderGraphResource resource);
+  // Keeps the pass even if none of its outputs are used.
+  void SideEffect();
+  // Splits the recording of the pass into count jobs recorded in parallel
+  // into secondary command buffers. The render function is called once per
+  // job and has to be thread-safe.
+  void RecordJobs(uint32_t count);
 
   // For use only by the render graph.
   std::vector<RenderGraphNode> Build(std::vector<RenderGraphPass>& passes);
+  // Serializes everything declared since the last Reset into key and returns
+  // its hash, frames with the same key build the same nodes.
+  uint64_t ComputeKey(size_t num_passes, std::vector<uint64_t>& key) const;
+  // Clear values aren't part of the key, sets the ones declared since the
+  // last Reset on the nodes of a build with the given render targets.
+  void SetClearValues(const std::vector<size_t>& node_targets,
+                      std::vector<RenderGraphNode>& nodes) const;
+  // Index of the first node accessing the resource in the last build.
+  static constexpr uint32_t kNotUsed = ~0u;
+  uint32_t GetFirstNodeUse(RenderGraphResource resource) const;
   void SetCurrentPass(RenderGraphPassHandle pass);
   void Reset();
 
@@ -35,17 +51,28 @@ class RenderGraphBuilder {
   RenderGraphPassHandle current_pass_;
 
   Generational::Manager handles_;
-
-  // Resources by use.
-  std::unordered_map<RenderGraphResource, std::vector<RenderGraphPassHandle>>
-      reads_;
-  std::unordered_map<RenderGraphResource, std::vector<RenderGraphPassHandle>>
-      writes_;
-  std::map<RenderGraphResource, std::vector<RenderGraphPassHandle>>
-      render_targets_;
-
-  // Resources.
+  // Resources are stored by handle index, which the handle manager keeps
+  // dense and restarts every frame.
+  size_t num_resources_ = 0;
+
+  // Every access of the frame in declaration order, grouped by resource when
+  // building.
+  struct ResourceUse {
+    RenderGraphResource resource;
+    RenderGraphPassHandle pass;
+    bool write;
+  };
+  std::vector<ResourceUse> uses_;
+  // Render target of every pass, kInvalidHandle for none.
+  std::vector<RenderGraphResource> pass_targets_;
+  std::vector<RenderGraphPassHandle> side_effects_;
+  std::vector<std::pair<RenderGraphPassHandle, uint32_t>> record_jobs_;
+  // Indexed by resource.
+  std::vector<uint32_t> first_node_uses_;
+
+  // Resources, a slot is in use when its handle matches.
   struct RenderGraphFramebufferResource {
+    RenderGraphResource handle = Generational::kInvalidHandle;
     RenderGraphFramebufferDesc desc;
     RenderGraphFramebuffer framebuffer;
     RenderGraphResourceTextures textures;
@@ -55,23 +82,58 @@ class RenderGraphBuilder {
   };
 
   struct RenderGraphTextureResource {
+    RenderGraphResource handle = Generational::kInvalidHandle;
     RenderGraphTextureDesc desc;
-    RenderAPI::ImageView texture;
+    RenderAPI::ImageView texture = RenderAPI::kInvalidHandle;
 
     bool transient = true;
     uint8_t ref_count = 0;
   };
 
-  std::unordered_map<RenderGraphResource, RenderGraphFramebufferResource>
-      framebuffers_;
-  std::unordered_map<RenderGraphResource, RenderGraphTextureResource> textures_;
+  std::vector<RenderGraphFramebufferResource> framebuffers_;
+  std::vector<RenderGraphTextureResource> textures_;
+  // Views of the textures for the scopes, indexed by resource.
+  std::vector<RenderAPI::ImageView> scope_textures_;
+  // Render target of every node of the last build, by resource index.
+  std::vector<size_t> node_targets_;
 
-  // Aliasing.
-  std::unordered_map<RenderGraphResource, RenderGraphResource> aliases_;
+  // Aliasing, the resource a resource was moved to or kInvalidHandle.
+  std::vector<RenderGraphResource> aliases_;
   RenderGraphResource GetAlised(RenderGraphResource handle) const;
 
+  // Scratch memory of Build, kept across frames.
+  struct Access {
+    RenderGraphPassHandle pass;
+    bool write;
+  };
+  std::vector<uint32_t> access_offsets_;
+  std::vector<Access> accesses_;
+  std::vector<Access> ordered_accesses_;
+  // Nodes reading a resource since its last write.
+  std::vector<uint32_t> reads_since_write_;
+  // Transient placements sorted by heap and offset.
+  std::vector<size_t> placement_order_;
+  // Dependencies as (pass, producer) and (pass, successor) pairs.
+  std::vector<std::pair<size_t, RenderGraphPassHandle>> producer_edges_;
+  std::vector<std::pair<size_t, RenderGraphPassHandle>> successor_edges_;
+  std::vector<uint32_t> producer_offsets_;
+  std::vector<RenderGraphPassHandle> producers_;
+  std::vector<uint32_t> successor_offsets_;
+  std::vector<RenderGraphPassHandle> successors_;
+  // Min-heaps of the ready passes, all of them and by render target.
+  std::vector<RenderGraphPassHandle> ready_;
+  std::vector<std::vector<RenderGraphPassHandle>> target_ready_;
+
   // Debug info.
   uint8_t debug_current_pass_render_targets_ = 0;
 
-  RenderGraphResource CreateTexture(RenderGraphTextureDesc info);
+  static size_t ResourceIndex(RenderGraphResource handle);
+  void AddResource(RenderGraphResource handle);
+  const RenderGraphResourceTextures& CreateRenderTarget(
+      const RenderGraphTextureDesc* descs, size_t count);
+  RenderGraphTextureResource* FindTexture(RenderGraphResource handle);
+  RenderGraphFramebufferResource* FindFramebuffer(RenderGraphResource handle);
+  RenderGraphTextureResource& CreateTexture(RenderGraphResource handle,
+                                            RenderGraphTextureDesc info);
+  void Alias(RenderGraphResource from, RenderGraphResource to);
 };
\ No newline at end of file
@@ -1,5 +1,82 @@
 #include "render_graph_cache.h"
 
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace {
+// Minimum size of a transient heap, large enough to hold a few full screen
+// targets.
+constexpr uint64_t kMinHeapSize = 64 * 1024 * 1024;
+
+bool LifetimesOverlap(uint32_t first_a, uint32_t last_a, uint32_t first_b,
+                      uint32_t last_b) {
+  return first_a <= last_b && first_b <= last_a;
+}
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+uint64_t Hash(const RenderGraphFramebufferDesc& desc,
+              const std::vector<RenderAPI::ImageView>& textures) {
+  uint64_t hash = desc.textures.size();
+  for (const auto& it : desc.textures) {
+    hash = HashCombine(hash, Hash(it));
+  }
+  for (auto it : textures) {
+    hash = HashCombine(hash, it);
+  }
+  return hash;
+}
+
+uint64_t Hash(const RenderAPI::RenderPassCreateInfo& info) {
+  uint64_t hash = info.attachments.size();
+  for (const auto& it : info.attachments) {
+    hash = HashCombine(hash, it.flags);
+    hash = HashCombine(hash, static_cast<uint64_t>(it.format));
+    hash = HashCombine(hash, static_cast<uint64_t>(it.samples));
+    hash = HashCombine(hash, static_cast<uint64_t>(it.load_op));
+    hash = HashCombine(hash, static_cast<uint64_t>(it.store_op));
+    hash = HashCombine(hash, static_cast<uint64_t>(it.stencil_load_op));
+    hash = HashCombine(hash, static_cast<uint64_t>(it.stencil_store_op));
+    hash = HashCombine(hash, static_cast<uint64_t>(it.initial_layout));
+    hash = HashCombine(hash, static_cast<uint64_t>(it.final_layout));
+  }
+  return hash;
+}
+
+bool operator==(const RenderAPI::RenderPassCreateInfo& a,
+                const RenderAPI::RenderPassCreateInfo& b) {
+  return std::equal(
+      a.attachments.begin(), a.attachments.end(), b.attachments.begin(),
+      b.attachments.end(),
+      [](const RenderAPI::AttachmentDescription& a,
+         const RenderAPI::AttachmentDescription& b) {
+        return a.flags == b.flags && a.format == b.format &&
+               a.samples == b.samples && a.load_op == b.load_op &&
+               a.store_op == b.store_op &&
+               a.stencil_load_op == b.stencil_load_op &&
+               a.stencil_store_op == b.stencil_store_op &&
+               a.initial_layout == b.initial_layout &&
+               a.final_layout == b.final_layout;
+      });
+}
+}  // namespace
+
+uint64_t HashCombine(uint64_t seed, uint64_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+// Hashes the fields compared by operator==.
+uint64_t Hash(const RenderGraphTextureDesc& desc) {
+  uint64_t hash = static_cast<uint64_t>(desc.format);
+  hash = HashCombine(hash, desc.width);
+  hash = HashCombine(hash, desc.height);
+  hash = HashCombine(hash, static_cast<uint64_t>(desc.load_op));
+  return HashCombine(hash, static_cast<uint64_t>(desc.layout));
+}
+
 bool operator==(const RenderGraphTextureDesc& a,
                 const RenderGraphTextureDesc& b) {
   return (a.format == b.format && a.width == b.width && a.height == b.height &&
@@ -17,33 +94,133 @@ void RenderGraphCache::PrepareBufferedResources(uint32_t size) {
   }
 }
 
-void RenderGraphCache::SetRenderObjects(RenderAPI::Device device,
-                                        RenderAPI::CommandPool pool) {
+void RenderGraphCache::SetRenderObjects(RenderAPI::Device device) {
   device_ = device;
-  pool_ = pool;
 }
 
 void RenderGraphCache::Reset() {
   resources_index_ = (resources_index_ + 1) % buffered_resources_.size();
-  buffered_resources_[resources_index_].cmd_index = 0;
+  for (auto& it : buffered_resources_[resources_index_].threads) {
+    it.cmd_index[0] = 0;
+    it.cmd_index[1] = 0;
+  }
   buffered_resources_[resources_index_].semaphore_index = 0;
 
-  for (auto& it : transient_buffers_) {
-    ++it.frames_since_use;
+  ++frame_;
+
+  // The memory of the last frame stays reserved while it's in flight, the
+  // memory of the frames that retired is free again.
+  const uint64_t frames_in_flight = buffered_resources_.size();
+  for (auto& heap : heaps_) {
+    for (const auto& it : heap.frame_ranges) {
+      heap.in_flight.push_back({it, frame_ - 1});
+    }
+    heap.frame_ranges.clear();
+    heap.in_flight.erase(
+        std::remove_if(heap.in_flight.begin(), heap.in_flight.end(),
+                       [this, frames_in_flight](const ReservedRange& it) {
+                         return it.frame + frames_in_flight <= frame_;
+                       }),
+        heap.in_flight.end());
+    std::sort(heap.in_flight.begin(), heap.in_flight.end(),
+              [](const ReservedRange& a, const ReservedRange& b) {
+                return a.range.offset < b.range.offset;
+              });
+    heap.max_reserved_size = 0;
+    for (const auto& it : heap.in_flight) {
+      heap.max_reserved_size = std::max(heap.max_reserved_size, it.range.size);
+    }
+    heap.frame_high_water = 0;
+  }
+  memory_stats_.naive_bytes = 0;
+  memory_stats_.high_water_bytes = 0;
+}
+
+RenderGraphTransients RenderGraphCache::GetFrameTransients() const {
+  RenderGraphTransients transients;
+  for (const auto& it : transient_textures_) {
+    if (it.last_used_frame == frame_) {
+      transients.textures.emplace_back(it.image_view);
+    }
+  }
+  for (const auto& it : transient_buffers_) {
+    if (it.last_used_frame == frame_) {
+      transients.framebuffers.emplace_back(it.resources.framebuffer);
+    }
+  }
+  for (const auto& heap : heaps_) {
+    transients.ranges.insert(transients.ranges.end(), heap.frame_ranges.begin(),
+                             heap.frame_ranges.end());
+  }
+  std::sort(transients.textures.begin(), transients.textures.end());
+  std::sort(transients.framebuffers.begin(), transients.framebuffers.end());
+  transients.memory = memory_stats_;
+  return transients;
+}
+
+RenderGraphCache::RetainResult RenderGraphCache::RetainTransients(
+    const RenderGraphTransients& transients) {
+  // Handles aren't reused, so the transients are all alive if every one of
+  // them is still found in the cache.
+  size_t num_textures = 0;
+  for (const auto& it : transient_textures_) {
+    num_textures += std::binary_search(transients.textures.begin(),
+                                       transients.textures.end(),
+                                       it.image_view);
+  }
+  size_t num_framebuffers = 0;
+  for (const auto& it : transient_buffers_) {
+    num_framebuffers += std::binary_search(transients.framebuffers.begin(),
+                                           transients.framebuffers.end(),
+                                           it.resources.framebuffer);
+  }
+  if (num_textures != transients.textures.size() ||
+      num_framebuffers != transients.framebuffers.size()) {
+    return RetainResult::kDestroyed;
+  }
+  for (const auto& it : transients.ranges) {
+    if (!IsRangeFree(it)) {
+      return RetainResult::kInUse;
+    }
+  }
+  for (const auto& it : transients.ranges) {
+    ReserveRange(it);
   }
   for (auto& it : transient_textures_) {
-    ++it.frames_since_use;
+    if (std::binary_search(transients.textures.begin(),
+                           transients.textures.end(), it.image_view)) {
+      it.last_used_frame = frame_;
+    }
   }
+  for (auto& it : transient_buffers_) {
+    if (std::binary_search(transients.framebuffers.begin(),
+                           transients.framebuffers.end(),
+                           it.resources.framebuffer)) {
+      it.last_used_frame = frame_;
+    }
+  }
+  memory_stats_.naive_bytes = transients.memory.naive_bytes;
+  memory_stats_.high_water_bytes = transients.memory.high_water_bytes;
+  return RetainResult::kRetained;
 }
 
-RenderAPI::CommandBuffer RenderGraphCache::AllocateCommand() {
-  if (buffered_resources_[resources_index_].cmd_index ==
-      buffered_resources_[resources_index_].cmds.size()) {
-    buffered_resources_[resources_index_].cmds.emplace_back(
-        RenderAPI::CreateCommandBuffer(pool_));
+RenderAPI::CommandBuffer RenderGraphCache::AllocateCommand(
+    uint32_t thread, RenderAPI::CommandBufferLevel level) {
+  auto& threads = buffered_resources_[resources_index_].threads;
+  if (thread >= threads.size()) {
+    threads.resize(thread + 1);
   }
-  return buffered_resources_[resources_index_]
-      .cmds[buffered_resources_[resources_index_].cmd_index++];
+  ThreadCommands& commands = threads[thread];
+  if (commands.pool == RenderAPI::kInvalidHandle) {
+    commands.pool = RenderAPI::CreateCommandPool(
+        device_, RenderAPI::CommandPoolCreateFlag::kResetCommand);
+  }
+  const size_t index = static_cast<size_t>(level);
+  auto& cmds = commands.cmds[index];
+  if (commands.cmd_index[index] == cmds.size()) {
+    cmds.emplace_back(RenderAPI::CreateCommandBuffer(commands.pool, level));
+  }
+  return cmds[commands.cmd_index[index]++];
 }
 
 RenderAPI::Semaphore RenderGraphCache::AllocateSemaphore() {
@@ -62,17 +239,342 @@ void RenderGraphCache::Destroy() {
       RenderAPI::DestroySemaphore(semaphore);
     }
     it.semaphores.clear();
+
+    for (auto& thread : it.threads) {
+      for (const auto& cmds : thread.cmds) {
+        for (auto cmd : cmds) {
+          RenderAPI::DestroyCommandBuffer(cmd);
+        }
+      }
+      if (thread.pool != RenderAPI::kInvalidHandle) {
+        RenderAPI::DestroyCommandPool(thread.pool);
+      }
+    }
+    it.threads.clear();
   }
 
   for (auto& it : transient_buffers_) {
     RenderAPI::DestroyFramebuffer(it.resources.framebuffer);
-    RenderAPI::DestroyRenderPass(it.resources.pass);
+    ReleaseRenderPass(it.resources.pass, it.render_pass_hash);
   }
+  assert(render_passes_.empty());
 
   for (auto& it : transient_textures_) {
     RenderAPI::DestroyImageView(device_, it.image_view);
     RenderAPI::DestroyImage(it.image);
   }
+  transient_textures_.clear();
+  transient_buffers_.clear();
+  texture_lookup_.clear();
+  framebuffer_lookup_.clear();
+
+  for (auto& it : heaps_) {
+    if (it.heap != RenderAPI::kInvalidHandle) {
+      RenderAPI::DestroyMemoryHeap(it.heap);
+    }
+  }
+  heaps_.clear();
+  memory_stats_ = RenderGraphMemoryStats();
+}
+
+const RenderGraphMemoryStats& RenderGraphCache::GetMemoryStats() const {
+  return memory_stats_;
+}
+
+const RenderGraphCacheStats& RenderGraphCache::GetStats() const {
+  return stats_;
+}
+
+void RenderGraphCache::SetPolicy(const RenderGraphCachePolicy& policy) {
+  policy_ = policy;
+}
+
+void RenderGraphCache::EvictUnused(uint32_t frames_in_flight) {
+  auto is_retired = [this, frames_in_flight](uint64_t last_used_frame) {
+    return last_used_frame + frames_in_flight <= frame_;
+  };
+
+  // Textures past the age threshold, then the least recently used ones until
+  // the heaps fit the budget.
+  std::vector<size_t> candidates;
+  std::vector<bool> evict(transient_textures_.size(), false);
+  for (size_t i = 0; i < transient_textures_.size(); ++i) {
+    const TransientTexture& texture = transient_textures_[i];
+    if (!is_retired(texture.last_used_frame)) {
+      continue;
+    }
+    if (frame_ - texture.last_used_frame > policy_.max_unused_frames) {
+      evict[i] = true;
+    } else {
+      candidates.emplace_back(i);
+    }
+  }
+  if (policy_.memory_budget) {
+    std::sort(candidates.begin(), candidates.end(), [this](size_t a, size_t b) {
+      return transient_textures_[a].last_used_frame <
+             transient_textures_[b].last_used_frame;
+    });
+    // Only heaps left without textures give memory back.
+    std::vector<uint32_t> remaining(heaps_.size());
+    for (size_t i = 0; i < heaps_.size(); ++i) {
+      remaining[i] = heaps_[i].num_textures;
+    }
+    uint64_t heap_bytes = memory_stats_.heap_bytes;
+    for (size_t i = 0; i < evict.size(); ++i) {
+      if (evict[i] && --remaining[transient_textures_[i].heap] == 0) {
+        heap_bytes -= heaps_[transient_textures_[i].heap].size;
+      }
+    }
+    for (size_t i = 0;
+         i < candidates.size() && heap_bytes > policy_.memory_budget; ++i) {
+      const size_t heap = transient_textures_[candidates[i]].heap;
+      evict[candidates[i]] = true;
+      if (--remaining[heap] == 0) {
+        heap_bytes -= heaps_[heap].size;
+      }
+    }
+  }
+
+  // Framebuffers past the age threshold or using an evicted texture. Those
+  // can't have been used after their textures so they're retired as well.
+  std::vector<RenderAPI::ImageView> evicted_views;
+  for (size_t i = 0; i < evict.size(); ++i) {
+    if (evict[i]) {
+      evicted_views.emplace_back(transient_textures_[i].image_view);
+    }
+  }
+  auto uses_evicted_view = [&evicted_views](const TransientFramebuffer& it) {
+    for (auto view : it.textures) {
+      if (std::find(evicted_views.begin(), evicted_views.end(), view) !=
+          evicted_views.end()) {
+        return true;
+      }
+    }
+    return false;
+  };
+  const size_t num_buffers = transient_buffers_.size();
+  for (size_t i = 0; i < transient_buffers_.size();) {
+    TransientFramebuffer& it = transient_buffers_[i];
+    if (is_retired(it.last_used_frame) &&
+        (frame_ - it.last_used_frame > policy_.max_unused_frames ||
+         uses_evicted_view(it))) {
+      RenderAPI::DestroyFramebuffer(it.resources.framebuffer);
+      ReleaseRenderPass(it.resources.pass, it.render_pass_hash);
+      ++stats_.framebuffer_evictions;
+      it = std::move(transient_buffers_.back());
+      transient_buffers_.pop_back();
+    } else {
+      ++i;
+    }
+  }
+  if (evicted_views.empty() && num_buffers == transient_buffers_.size()) {
+    return;
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < transient_textures_.size(); ++i) {
+    if (evict[i]) {
+      DestroyTexture(transient_textures_[i]);
+      ++stats_.texture_evictions;
+    } else {
+      if (kept != i) {
+        transient_textures_[kept] = std::move(transient_textures_[i]);
+      }
+      ++kept;
+    }
+  }
+  transient_textures_.resize(kept);
+  RebuildLookups();
+}
+
+void RenderGraphCache::RebuildLookups() {
+  for (auto& it : texture_lookup_) {
+    it.second.all.clear();
+  }
+  for (auto& it : framebuffer_lookup_) {
+    it.second.all.clear();
+  }
+  for (size_t i = 0; i < transient_textures_.size(); ++i) {
+    texture_lookup_[transient_textures_[i].hash].all.emplace_back(i);
+  }
+  for (size_t i = 0; i < transient_buffers_.size(); ++i) {
+    framebuffer_lookup_[transient_buffers_[i].hash].all.emplace_back(i);
+  }
+  for (auto it = texture_lookup_.begin(); it != texture_lookup_.end();) {
+    it = it->second.all.empty() ? texture_lookup_.erase(it) : std::next(it);
+  }
+  for (auto it = framebuffer_lookup_.begin();
+       it != framebuffer_lookup_.end();) {
+    it = it->second.all.empty() ? framebuffer_lookup_.erase(it)
+                                : std::next(it);
+  }
+  // The indices moved, refill the free lists. The transients already used
+  // this frame are dropped by the lookups.
+  for (auto& it : texture_lookup_) {
+    it.second.frame = ~0ull;
+  }
+  for (auto& it : framebuffer_lookup_) {
+    it.second.frame = ~0ull;
+  }
+}
+
+std::vector<size_t>& RenderGraphCache::GetFreeList(Lookup& lookup) {
+  if (lookup.frame != frame_) {
+    // Lookups pop from the back, so the oldest entries are handed out first.
+    lookup.free.assign(lookup.all.rbegin(), lookup.all.rend());
+    lookup.frame = frame_;
+  }
+  return lookup.free;
+}
+
+size_t RenderGraphCache::CreateHeap(uint64_t size, uint32_t memory_type_bits) {
+  TransientHeap heap;
+  heap.size = size;
+  heap.memory_type_bits = memory_type_bits;
+  heap.heap = RenderAPI::CreateMemoryHeap(device_, size, memory_type_bits);
+  memory_stats_.heap_bytes += size;
+
+  for (size_t i = 0; i < heaps_.size(); ++i) {
+    if (heaps_[i].heap == RenderAPI::kInvalidHandle) {
+      heaps_[i] = std::move(heap);
+      return i;
+    }
+  }
+  heaps_.emplace_back(std::move(heap));
+  return heaps_.size() - 1;
+}
+
+void RenderGraphCache::DestroyTexture(const TransientTexture& texture) {
+  RenderAPI::DestroyImageView(device_, texture.image_view);
+  RenderAPI::DestroyImage(texture.image);
+
+  TransientHeap& heap = heaps_[texture.heap];
+  if (--heap.num_textures == 0) {
+    RenderAPI::DestroyMemoryHeap(heap.heap);
+    memory_stats_.heap_bytes -= heap.size;
+    heap.heap = RenderAPI::kInvalidHandle;
+    heap.size = 0;
+  }
+}
+
+bool RenderGraphCache::IsRangeFree(const RenderGraphMemoryRange& range) const {
+  // Only ranges starting less than the largest size before the end of this
+  // one can overlap it.
+  const TransientHeap& heap = heaps_[range.heap];
+  const uint64_t end = range.offset + range.size;
+  const uint64_t first_offset = range.offset > heap.max_reserved_size
+                                    ? range.offset - heap.max_reserved_size
+                                    : 0;
+
+  // A texture reusing its own memory is ordered after its earlier frames by
+  // the queue like any other persistent texture.
+  auto in_flight = std::lower_bound(
+      heap.in_flight.begin(), heap.in_flight.end(), first_offset,
+      [](const ReservedRange& reserved, uint64_t offset) {
+        return reserved.range.offset < offset;
+      });
+  for (; in_flight != heap.in_flight.end() && in_flight->range.offset < end;
+       ++in_flight) {
+    if (in_flight->range.offset + in_flight->range.size > range.offset &&
+        in_flight->range.texture != range.texture) {
+      return false;
+    }
+  }
+
+  // The ranges of this frame at an offset are sorted by lifetime, only the
+  // ones from the first ending after this one begins can overlap it.
+  auto it = std::lower_bound(
+      heap.frame_ranges.begin(), heap.frame_ranges.end(), first_offset,
+      [](const RenderGraphMemoryRange& reserved, uint64_t offset) {
+        return reserved.offset < offset;
+      });
+  while (it != heap.frame_ranges.end() && it->offset < end) {
+    auto next = std::upper_bound(
+        it, heap.frame_ranges.end(), it->offset,
+        [](uint64_t offset, const RenderGraphMemoryRange& reserved) {
+          return offset < reserved.offset;
+        });
+    auto alive = std::lower_bound(
+        it, next, range.first_use,
+        [](const RenderGraphMemoryRange& reserved, uint32_t first_use) {
+          return reserved.last_use < first_use;
+        });
+    for (; alive != next && alive->first_use <= range.last_use; ++alive) {
+      if (alive->offset + alive->size > range.offset) {
+        return false;
+      }
+    }
+    it = next;
+  }
+  return true;
+}
+
+bool RenderGraphCache::FindHeapOffset(size_t heap, uint64_t size,
+                                      uint64_t alignment, uint32_t first_use,
+                                      uint32_t last_use,
+                                      uint64_t& offset) const {
+  // First fit between the ranges alive at the same time, walking both lists
+  // by offset. The ones of earlier frames in flight are alive for the whole
+  // frame.
+  const std::vector<ReservedRange>& in_flight = heaps_[heap].in_flight;
+  const std::vector<RenderGraphMemoryRange>& frame_ranges =
+      heaps_[heap].frame_ranges;
+  size_t in_flight_index = 0;
+  size_t frame_index = 0;
+  uint64_t candidate = 0;
+  for (;;) {
+    while (frame_index < frame_ranges.size() &&
+           !LifetimesOverlap(frame_ranges[frame_index].first_use,
+                             frame_ranges[frame_index].last_use, first_use,
+                             last_use)) {
+      ++frame_index;
+    }
+    const RenderGraphMemoryRange* next;
+    if (in_flight_index < in_flight.size() &&
+        (frame_index == frame_ranges.size() ||
+         in_flight[in_flight_index].range.offset <=
+             frame_ranges[frame_index].offset)) {
+      next = &in_flight[in_flight_index++].range;
+    } else if (frame_index < frame_ranges.size()) {
+      next = &frame_ranges[frame_index++];
+    } else {
+      break;
+    }
+    if (candidate + size <= next->offset) {
+      break;
+    }
+    candidate =
+        std::max(candidate, AlignUp(next->offset + next->size, alignment));
+  }
+  if (candidate + size > heaps_[heap].size) {
+    return false;
+  }
+  offset = candidate;
+  return true;
+}
+
+void RenderGraphCache::ReserveRange(const RenderGraphMemoryRange& range) {
+  TransientHeap& heap = heaps_[range.heap];
+  auto it = std::upper_bound(
+      heap.frame_ranges.begin(), heap.frame_ranges.end(), range,
+      [](const RenderGraphMemoryRange& a, const RenderGraphMemoryRange& b) {
+        return a.offset != b.offset ? a.offset < b.offset
+                                    : a.first_use < b.first_use;
+      });
+  heap.frame_ranges.insert(it, range);
+  heap.max_reserved_size = std::max(heap.max_reserved_size, range.size);
+}
+
+void RenderGraphCache::UseRange(const RenderGraphMemoryRange& range) {
+  ReserveRange(range);
+
+  TransientHeap& heap = heaps_[range.heap];
+  const uint64_t end = range.offset + range.size;
+  if (end > heap.frame_high_water) {
+    memory_stats_.high_water_bytes += end - heap.frame_high_water;
+    heap.frame_high_water = end;
+  }
+  memory_stats_.naive_bytes += range.size;
 }
 
 RenderAPI::ImageAspectFlags GetAspectFlagBits(RenderAPI::TextureFormat format) {
@@ -105,67 +607,154 @@ RenderAPI::ImageUsageFlags GetImageUsageFlagsForFormat(
 }
 
 RenderAPI::ImageView RenderGraphCache::CreateTransientTexture(
-    const RenderGraphTextureDesc& info) {
-  for (auto& it : transient_textures_) {
-    if (it.frames_since_use > 0 && it.info == info) {
-      it.frames_since_use = 0;
+    const RenderGraphTextureDesc& info, uint32_t first_use, uint32_t last_use,
+    RenderGraphMemoryRange* range) {
+  const uint64_t hash = Hash(info);
+  const auto bucket = texture_lookup_.find(hash);
+  if (bucket != texture_lookup_.end()) {
+    std::vector<size_t>& free_textures = GetFreeList(bucket->second);
+    for (size_t i = free_textures.size(); i-- > 0;) {
+      TransientTexture& it = transient_textures_[free_textures[i]];
+      if (it.last_used_frame == frame_) {
+        free_textures[i] = free_textures.back();
+        free_textures.pop_back();
+        continue;
+      }
+      if (!(it.info == info)) {
+        continue;
+      }
+      // The memory may have been handed to a texture alive at the same time,
+      // the texture stays free for another lifetime.
+      const RenderGraphMemoryRange memory = {
+          it.heap, it.offset, it.size, first_use, last_use, it.image_view};
+      if (!IsRangeFree(memory)) {
+        continue;
+      }
+      free_textures[i] = free_textures.back();
+      free_textures.pop_back();
+      UseRange(memory);
+      if (range) {
+        *range = memory;
+      }
+      it.last_used_frame = frame_;
+      ++stats_.texture_hits;
       return it.image_view;
     }
   }
 
-  // Create a new transient texture.
+  // Place a new transient texture in the first heap that has room.
+  ++stats_.texture_misses;
   TransientTexture texture;
+  texture.last_used_frame = frame_;
   RenderAPI::ImageCreateInfo image_create_info(
       RenderAPI::TextureType::Texture2D, info.format,
       RenderAPI::Extent3D(info.width, info.height, 1),
       GetImageUsageFlagsForFormat(info.format));
-  texture.image = RenderAPI::CreateImage(device_, image_create_info);
+  const RenderAPI::MemoryRequirements requirements =
+      RenderAPI::GetImageMemoryRequirements(device_, image_create_info);
+  texture.heap = heaps_.size();
+  for (size_t i = 0; i < heaps_.size(); ++i) {
+    if (heaps_[i].heap != RenderAPI::kInvalidHandle &&
+        heaps_[i].memory_type_bits == requirements.memory_type_bits &&
+        FindHeapOffset(i, requirements.size, requirements.alignment,
+                       first_use, last_use, texture.offset)) {
+      texture.heap = i;
+      break;
+    }
+  }
+  if (texture.heap == heaps_.size()) {
+    texture.heap = CreateHeap(std::max(kMinHeapSize, requirements.size),
+                              requirements.memory_type_bits);
+    texture.offset = 0;
+  }
+  ++heaps_[texture.heap].num_textures;
+  texture.size = requirements.size;
+
+  texture.image = RenderAPI::CreateAliasedImage(
+      device_, image_create_info, heaps_[texture.heap].heap, texture.offset);
   const RenderAPI::ImageAspectFlags aspect_bits =
       GetAspectFlagBits(info.format);
   RenderAPI::ImageViewCreateInfo image_view_info(
       texture.image, RenderAPI::ImageViewType::Texture2D, info.format,
       RenderAPI::ImageSubresourceRange(aspect_bits));
   texture.image_view = RenderAPI::CreateImageView(device_, image_view_info);
+  const RenderGraphMemoryRange memory = {texture.heap, texture.offset,
+                                         texture.size, first_use, last_use,
+                                         texture.image_view};
+  UseRange(memory);
+  if (range) {
+    *range = memory;
+  }
   texture.info = info;
+  texture.hash = hash;
+  texture_lookup_[hash].all.emplace_back(transient_textures_.size());
   transient_textures_.emplace_back(std::move(texture));
   return transient_textures_.back().image_view;
 }
 
 const RenderGraphFramebuffer& RenderGraphCache::CreateTransientFramebuffer(
     const RenderGraphFramebufferDesc& info,
-    const std::vector<RenderAPI::ImageView>& textures) {
-  for (TransientFramebuffer& it : transient_buffers_) {
-    if (it.frames_since_use > 0 && it.info == info && textures == it.textures) {
-      it.frames_since_use = 0;
-      return it.resources;
+    const std::vector<RenderAPI::ImageView>& textures, uint32_t load_mask) {
+  assert(info.textures.size() <= 32 && "Too many attachments!");
+  const uint64_t hash = HashCombine(Hash(info, textures), load_mask);
+  const auto bucket = framebuffer_lookup_.find(hash);
+  if (bucket != framebuffer_lookup_.end()) {
+    std::vector<size_t>& free_buffers = GetFreeList(bucket->second);
+    for (size_t i = free_buffers.size(); i-- > 0;) {
+      TransientFramebuffer& it = transient_buffers_[free_buffers[i]];
+      if (it.last_used_frame == frame_) {
+        free_buffers[i] = free_buffers.back();
+        free_buffers.pop_back();
+        continue;
+      }
+      if (it.info == info && it.load_mask == load_mask &&
+          textures == it.textures) {
+        free_buffers[i] = free_buffers.back();
+        free_buffers.pop_back();
+        it.last_used_frame = frame_;
+        ++stats_.framebuffer_hits;
+        return it.resources;
+      }
     }
   }
 
+  ++stats_.framebuffer_misses;
   TransientFramebuffer buffer;
   buffer.textures = textures;
+  buffer.last_used_frame = frame_;
 
   RenderAPI::RenderPassCreateInfo render_pass_info;
-  for (const auto& texture_desc : info.textures) {
+  for (size_t i = 0; i < info.textures.size(); ++i) {
+    const RenderGraphTextureDesc& texture_desc = info.textures[i];
     const RenderAPI::ImageAspectFlags aspect_bits =
         GetAspectFlagBits(texture_desc.format);
 
+    // The earlier node left the texture in its final layout.
+    const bool load_contents = (load_mask >> i) & 1;
+    const RenderAPI::AttachmentLoadOp load_op =
+        load_contents ? RenderAPI::AttachmentLoadOp::kLoad
+                      : texture_desc.load_op;
     RenderAPI::AttachmentDescription attachment;
+    if (load_contents) {
+      attachment.initial_layout = texture_desc.layout;
+    }
     attachment.final_layout = texture_desc.layout;
     attachment.format = texture_desc.format;
-    attachment.load_op = texture_desc.load_op;
+    attachment.load_op = load_op;
     attachment.store_op = RenderAPI::AttachmentStoreOp::kStore;
     if (aspect_bits & RenderAPI::ImageAspectFlagBits::kDepthBit ||
         aspect_bits & RenderAPI::ImageAspectFlagBits::kStencilBit) {
-      attachment.load_op = texture_desc.load_op;
+      attachment.load_op = load_op;
       attachment.store_op = RenderAPI::AttachmentStoreOp::kStore;
-      attachment.stencil_load_op = texture_desc.load_op;
+      attachment.stencil_load_op = load_op;
       attachment.stencil_store_op = RenderAPI::AttachmentStoreOp::kStore;
     }
     render_pass_info.attachments.emplace_back(std::move(attachment));
   }
 
+  buffer.render_pass_hash = Hash(render_pass_info);
   buffer.resources.pass =
-      RenderAPI::CreateRenderPass(device_, render_pass_info);
+      AcquireRenderPass(render_pass_info, buffer.render_pass_hash);
 
   RenderAPI::FramebufferCreateInfo fb_info;
   fb_info.pass = buffer.resources.pass;
@@ -180,6 +769,51 @@ const RenderGraphFramebuffer& RenderGraphCache::CreateTransientFramebuffer(
   buffer.resources.render_area = {0, 0, fb_info.width, fb_info.height};
 
   buffer.info = info;
+  buffer.load_mask = load_mask;
+  buffer.hash = hash;
+  framebuffer_lookup_[hash].all.emplace_back(transient_buffers_.size());
   transient_buffers_.emplace_back(std::move(buffer));
   return transient_buffers_.back().resources;
 }
+
+RenderAPI::RenderPass RenderGraphCache::AcquireRenderPass(
+    const RenderAPI::RenderPassCreateInfo& info, uint64_t hash) {
+  std::vector<CachedRenderPass>& bucket = render_passes_[hash];
+  for (auto& it : bucket) {
+    if (it.info == info) {
+      ++it.refs;
+      ++stats_.render_pass_hits;
+      return it.pass;
+    }
+  }
+
+  ++stats_.render_pass_misses;
+  CachedRenderPass render_pass;
+  render_pass.info = info;
+  render_pass.pass = RenderAPI::CreateRenderPass(device_, info);
+  render_pass.refs = 1;
+  bucket.emplace_back(std::move(render_pass));
+  return bucket.back().pass;
+}
+
+void RenderGraphCache::ReleaseRenderPass(RenderAPI::RenderPass pass,
+                                         uint64_t hash) {
+  auto bucket = render_passes_.find(hash);
+  assert(bucket != render_passes_.end() && "Unknown render pass!");
+  auto& passes = bucket->second;
+  for (size_t i = 0; i < passes.size(); ++i) {
+    if (passes[i].pass != pass) {
+      continue;
+    }
+    if (--passes[i].refs == 0) {
+      RenderAPI::DestroyRenderPass(pass);
+      passes[i] = std::move(passes.back());
+      passes.pop_back();
+      if (passes.empty()) {
+        render_passes_.erase(bucket);
+      }
+    }
+    return;
+  }
+  assert(false && "Unknown render pass!");
+}
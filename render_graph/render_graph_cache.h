@@ -5,32 +5,90 @@
 #include "generational/generational.h"
 #include "render_graph_resources.h"
 
+// Memory of a transient heap a texture occupies from its first_use to its
+// last_use node (inclusive).
+struct RenderGraphMemoryRange {
+  size_t heap;
+  uint64_t offset;
+  uint64_t size;
+  uint32_t first_use;
+  uint32_t last_use;
+  RenderAPI::ImageView texture;
+};
+
+// The transients used by a frame, see RenderGraphCache::GetFrameTransients.
+struct RenderGraphTransients {
+  // Sorted.
+  std::vector<RenderAPI::ImageView> textures;
+  std::vector<RenderAPI::Framebuffer> framebuffers;
+  std::vector<RenderGraphMemoryRange> ranges;
+
+  RenderGraphMemoryStats memory;
+};
+
 class RenderGraphCache {
  public:
   void PrepareBufferedResources(uint32_t size);
 
+  // The texture is alive from the first_use to the last_use node (inclusive),
+  // textures of the frame whose lifetimes don't overlap may share memory.
+  // Memory used by earlier frames still in flight is left alone. range is set
+  // to the memory the texture occupies.
   RenderAPI::ImageView CreateTransientTexture(
-      const RenderGraphTextureDesc& info);
+      const RenderGraphTextureDesc& info, uint32_t first_use,
+      uint32_t last_use, RenderGraphMemoryRange* range = nullptr);
+  // Attachment i of the render pass loads what an earlier node wrote to it
+  // when bit i of load_mask is set, instead of using the description's load
+  // op.
   const RenderGraphFramebuffer& CreateTransientFramebuffer(
       const RenderGraphFramebufferDesc& info,
-      const std::vector<RenderAPI::ImageView>& textures);
+      const std::vector<RenderAPI::ImageView>& textures,
+      uint32_t load_mask = 0);
 
-  RenderAPI::CommandBuffer AllocateCommand();
+  // Every recording thread has its own command pool per buffered frame, so
+  // command buffers of different threads can be recorded concurrently.
+  RenderAPI::CommandBuffer AllocateCommand(
+      uint32_t thread = 0,
+      RenderAPI::CommandBufferLevel level =
+          RenderAPI::CommandBufferLevel::kPrimary);
   RenderAPI::Semaphore AllocateSemaphore();
 
-  void SetRenderObjects(RenderAPI::Device device, RenderAPI::CommandPool pool);
+  void SetRenderObjects(RenderAPI::Device device);
   void Reset();
 
+  // The transients the current frame has used so far.
+  RenderGraphTransients GetFrameTransients() const;
+  // Marks the transients an earlier frame used as used by the current one
+  // instead of looking them up again. Fails if any transient was destroyed
+  // since they were gathered, or if their memory is held by another texture
+  // of a frame still in flight.
+  enum class RetainResult { kRetained, kInUse, kDestroyed };
+  RetainResult RetainTransients(const RenderGraphTransients& transients);
+
+  // Destroys transients according to the policy. Only transients whose last
+  // frame is at least frames_in_flight frames old are considered, the caller
+  // must have waited on the fence of that frame.
+  void EvictUnused(uint32_t frames_in_flight);
+  void SetPolicy(const RenderGraphCachePolicy& policy);
+
   void Destroy();
 
+  const RenderGraphMemoryStats& GetMemoryStats() const;
+  const RenderGraphCacheStats& GetStats() const;
+
  private:
   RenderAPI::Device device_;
-  RenderAPI::CommandPool pool_;
 
   uint32_t resources_index_ = 0;
+  uint64_t frame_ = 0;
+  struct ThreadCommands {
+    RenderAPI::CommandPool pool = RenderAPI::kInvalidHandle;
+    // Indexed by RenderAPI::CommandBufferLevel.
+    size_t cmd_index[2] = {};
+    std::vector<RenderAPI::CommandBuffer> cmds[2];
+  };
   struct BufferedResources {
-    size_t cmd_index = 0;
-    std::vector<RenderAPI::CommandBuffer> cmds;
+    std::vector<ThreadCommands> threads;
     size_t semaphore_index = 0;
     std::vector<RenderAPI::Semaphore> semaphores;
   };
@@ -38,20 +96,97 @@ class RenderGraphCache {
 
   struct TransientTexture {
     RenderGraphTextureDesc info;
+    uint64_t hash;
 
     RenderAPI::ImageView image_view;
     RenderAPI::Image image;
 
-    uint8_t frames_since_use = 0;
+    // Placement in the transient heaps.
+    size_t heap;
+    uint64_t offset;
+    uint64_t size;
+
+    uint64_t last_used_frame = 0;
   };
   struct TransientFramebuffer {
     RenderGraphFramebufferDesc info;
+    uint32_t load_mask;
+    uint64_t hash;
+    uint64_t render_pass_hash;
 
     RenderGraphFramebuffer resources;
     std::vector<RenderAPI::ImageView> textures;
 
-    uint8_t frames_since_use = 0;
+    uint64_t last_used_frame = 0;
   };
   std::vector<TransientFramebuffer> transient_buffers_;
   std::vector<TransientTexture> transient_textures_;
+
+  // Indices of the cached transients by the hash of their description. The
+  // free list holds the ones not used yet this frame, lookups pop it and it
+  // is refilled from all of them by the first lookup of a frame.
+  struct Lookup {
+    std::vector<size_t> all;
+    std::vector<size_t> free;
+    // Frame the free list was filled for.
+    uint64_t frame = ~0ull;
+  };
+  std::unordered_map<uint64_t, Lookup> texture_lookup_;
+  std::unordered_map<uint64_t, Lookup> framebuffer_lookup_;
+  std::vector<size_t>& GetFreeList(Lookup& lookup);
+  void RebuildLookups();
+
+  // Render passes by the hash of their description, shared by the transient
+  // framebuffers and destroyed with the last one using them.
+  struct CachedRenderPass {
+    RenderAPI::RenderPassCreateInfo info;
+    RenderAPI::RenderPass pass;
+    uint32_t refs = 0;
+  };
+  std::unordered_map<uint64_t, std::vector<CachedRenderPass>> render_passes_;
+  RenderAPI::RenderPass AcquireRenderPass(
+      const RenderAPI::RenderPassCreateInfo& info, uint64_t hash);
+  void ReleaseRenderPass(RenderAPI::RenderPass pass, uint64_t hash);
+
+  // Memory aliasing.
+  struct ReservedRange {
+    RenderGraphMemoryRange range;
+    uint64_t frame;
+  };
+  // Heaps are never erased so textures can refer to them by index, destroyed
+  // heaps are invalidated and their slot is reused.
+  struct TransientHeap {
+    RenderAPI::MemoryHeap heap;
+    uint64_t size;
+    uint32_t memory_type_bits;
+    // End of the furthest range used this frame.
+    uint64_t frame_high_water = 0;
+    uint32_t num_textures = 0;
+    // Memory in use by the transients of the earlier frames still in flight,
+    // sorted by offset. They block every other texture for their whole frame,
+    // the GPU may still be using them.
+    std::vector<ReservedRange> in_flight;
+    // Memory in use by the transients of this frame, sorted by offset then
+    // first use. Ranges overlapping in memory have disjoint lifetimes, so the
+    // ones at the same offset are sorted by last use as well.
+    std::vector<RenderGraphMemoryRange> frame_ranges;
+    // Size of the largest reserved range, bounds how far before an offset
+    // ranges overlapping it can start.
+    uint64_t max_reserved_size = 0;
+  };
+  std::vector<TransientHeap> heaps_;
+  RenderGraphMemoryStats memory_stats_;
+
+  // Eviction.
+  RenderGraphCachePolicy policy_;
+  RenderGraphCacheStats stats_;
+
+  bool IsRangeFree(const RenderGraphMemoryRange& range) const;
+  bool FindHeapOffset(size_t heap, uint64_t size, uint64_t alignment,
+                      uint32_t first_use, uint32_t last_use,
+                      uint64_t& offset) const;
+  void ReserveRange(const RenderGraphMemoryRange& range);
+  void UseRange(const RenderGraphMemoryRange& range);
+  size_t CreateHeap(uint64_t size, uint32_t memory_type_bits);
+  void DestroyTexture(const TransientTexture& texture);
 };
\ No newline at end of file
@@ -3,12 +3,21 @@
 #include <RenderAPI/RenderAPI.h>
 #include <cstdint>
 #include <functional>
+#include <string_view>
+#include <vector>
+#include "render_graph_arena.h"
 
 class RenderGraphBuilder;
 struct RenderContext {
   RenderAPI::CommandBuffer cmd;
   RenderAPI::RenderPass pass;
   RenderAPI::Framebuffer framebuffer;
+  RenderAPI::PipelineCache pipeline_cache = RenderAPI::kInvalidHandle;
+
+  // Passes recorded in jobs are called once per job, each with its own
+  // command buffer, see RenderGraphBuilder::RecordJobs.
+  uint32_t job = 0;
+  uint32_t job_count = 1;
 };
 
 class Scope {
@@ -16,38 +25,44 @@ class Scope {
   RenderAPI::ImageView GetTexture(RenderGraphResource resource) const;
 
  private:
+  friend class RenderGraph;
   friend class RenderGraphBuilder;
-  std::unordered_map<RenderGraphResource, RenderAPI::ImageView> textures_;
+  // Views of the frame's textures by resource index, shared by every pass.
+  const std::vector<RenderAPI::ImageView>* textures_ = nullptr;
 };
 
+// Stored in the render graph's frame arena, see RenderGraph::AddPass.
 using RenderGraphRenderFn =
-    std::function<void(RenderContext* context, const Scope& scope)>;
-using RenderGraphSetupFn = std::function<void(RenderGraphBuilder&)>;
+    RenderGraphFunction<void(RenderContext* context, const Scope& scope)>;
 
 struct RenderGraphPassInfo {
   RenderAPI::RenderPassCreateInfo pass;
 };
 
 struct RenderGraphPass {
-  std::string name;
+  // Valid until the end of the frame.
+  std::string_view name;
   RenderGraphRenderFn fn;
-  RenderGraphSetupFn setup;
+  uint32_t record_jobs = 1;
 
   Scope scope;
-
-  uint8_t ref_count = 0;
 };
 
 struct RenderGraphCombinedRenderPasses {
   std::vector<RenderGraphPass*> passes;
 
   RenderGraphFramebuffer framebuffer;
+
+  // When any pass records in jobs, every pass is recorded into these and the
+  // render pass only executes them.
+  std::vector<RenderAPI::CommandBuffer> secondary_cmds;
 };
 
 struct RenderGraphNode {
   std::vector<RenderGraphCombinedRenderPasses> render_passes;
 
+  // Waits on the nodes this one depends on, recorded before the render passes.
+  RenderAPI::PipelineBarrier barrier;
+
   RenderAPI::CommandBuffer render_cmd = RenderAPI::kInvalidHandle;
-  std::vector<RenderAPI::Semaphore> wait_semaphores;
-  std::vector<RenderAPI::Semaphore> signal_semaphores;
 };
@@ -31,4 +31,49 @@ struct RenderGraphTextureDesc {
 
 struct RenderGraphFramebufferDesc {
   std::vector<RenderGraphTextureDesc> textures;
+};
+
+uint64_t HashCombine(uint64_t seed, uint64_t value);
+// Hashes the fields compared when looking up cached transients, clear values
+// aren't part of it.
+uint64_t Hash(const RenderGraphTextureDesc& desc);
+
+// Transient texture memory of the current frame.
+struct RenderGraphMemoryStats {
+  // What the transients would take with a dedicated allocation each.
+  uint64_t naive_bytes = 0;
+  // Peak memory used once transients with disjoint lifetimes share memory.
+  uint64_t high_water_bytes = 0;
+  // Total size of the heaps backing the transients.
+  uint64_t heap_bytes = 0;
+};
+
+// When cached transients that went unused get destroyed.
+struct RenderGraphCachePolicy {
+  // Frames a transient may go unused before it is destroyed.
+  uint32_t max_unused_frames = 60;
+  // Heap memory above which the least recently used transients are destroyed,
+  // zero for no budget.
+  uint64_t memory_budget = 0;
+};
+
+// Lifetime counters of the transient caches.
+struct RenderGraphCacheStats {
+  uint64_t texture_hits = 0;
+  uint64_t texture_misses = 0;
+  uint64_t texture_evictions = 0;
+  uint64_t framebuffer_hits = 0;
+  uint64_t framebuffer_misses = 0;
+  uint64_t framebuffer_evictions = 0;
+  // Framebuffers with the same attachments share a render pass, hits are
+  // creations avoided.
+  uint64_t render_pass_hits = 0;
+  uint64_t render_pass_misses = 0;
+};
+
+// Lifetime counters of the compiled graph cache. A hit reuses the nodes and
+// transients of an earlier frame with the same passes and resources.
+struct RenderGraphCompileStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
 };
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "render_graph_workers.h"
+
+#include <cassert>
+
+RenderGraphWorkers::~RenderGraphWorkers() { StopThreads(); }
+
+void RenderGraphWorkers::SetThreadCount(uint32_t count) {
+  assert(count > 0);
+  if (count == GetThreadCount()) {
+    return;
+  }
+
+  StopThreads();
+  quit_ = false;
+  for (uint32_t worker = 1; worker < count; ++worker) {
+    threads_.emplace_back(&RenderGraphWorkers::WorkerLoop, this, worker,
+                          generation_);
+  }
+}
+
+uint32_t RenderGraphWorkers::GetThreadCount() const {
+  return static_cast<uint32_t>(threads_.size()) + 1;
+}
+
+void RenderGraphWorkers::Run(const std::function<void(uint32_t)>& fn) {
+  if (threads_.empty()) {
+    fn(0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = &fn;
+    pending_ = static_cast<uint32_t>(threads_.size());
+    exception_ = nullptr;
+    ++generation_;
+  }
+  start_cv_.notify_all();
+
+  std::exception_ptr exception;
+  try {
+    fn(0);
+  } catch (...) {
+    exception = std::current_exception();
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this] { return pending_ == 0; });
+  job_ = nullptr;
+  if (!exception) {
+    exception = exception_;
+  }
+  lock.unlock();
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+void RenderGraphWorkers::WorkerLoop(uint32_t worker, uint64_t generation) {
+  while (true) {
+    const std::function<void(uint32_t)>* job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_cv_.wait(lock,
+                     [&] { return quit_ || generation_ != generation; });
+      if (quit_) {
+        return;
+      }
+      generation = generation_;
+      job = job_;
+    }
+
+    std::exception_ptr exception;
+    try {
+      (*job)(worker);
+    } catch (...) {
+      exception = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (exception && !exception_) {
+        exception_ = exception;
+      }
+      --pending_;
+    }
+    done_cv_.notify_one();
+  }
+}
+
+void RenderGraphWorkers::StopThreads() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  start_cv_.notify_all();
+  for (auto& it : threads_) {
+    it.join();
+  }
+  threads_.clear();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent threads used to record the render graph nodes in parallel.
+class RenderGraphWorkers {
+ public:
+  ~RenderGraphWorkers();
+
+  // Number of workers including the calling thread, 1 runs everything inline.
+  void SetThreadCount(uint32_t count);
+  uint32_t GetThreadCount() const;
+
+  // Calls fn(worker) once on every worker, the calling thread is worker 0.
+  // Returns when all the workers are done, rethrowing the first exception.
+  void Run(const std::function<void(uint32_t)>& fn);
+
+ private:
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+
+  const std::function<void(uint32_t)>* job_ = nullptr;
+  uint64_t generation_ = 0;
+  uint32_t pending_ = 0;
+  bool quit_ = false;
+  std::exception_ptr exception_;
+
+  // generation is the last job the worker has seen.
+  void WorkerLoop(uint32_t worker, uint64_t generation);
+  void StopThreads();
+};
@@ -44,7 +44,8 @@ void DestroyCascadeImagesAndViews(RenderAPI::Device device,
   RenderAPI::DestroyImage(pass.depth_image);
 }
 
-CascadeShadowsPass CascadeShadowsPass::Create(RenderAPI::Device device) {
+CascadeShadowsPass CascadeShadowsPass::Create(
+    RenderAPI::Device device, RenderAPI::PipelineCache pipeline_cache) {
   CascadeShadowsPass pass;
 
   pass.num_cascades = 4;
@@ -59,6 +60,7 @@ CascadeShadowsPass CascadeShadowsPass::Create(RenderAPI::Device device) {
       util::ReadFile("samples/render_graph/pbr/data/shadow_depth.frag.spv");
 
   Material::Builder builder(device);
+  builder.PipelineCache(pipeline_cache);
   builder.PushConstant(RenderAPI::ShaderStageFlagBits::kVertexBit,
                        sizeof(glm::mat4));
   builder.VertexCode(reinterpret_cast<const uint32_t*>(vert.data()),
@@ -107,6 +109,9 @@ void AddCascadePass(CascadeShadowsPass* shadow, RenderAPI::Device device,
 
         size_t instance_id = 0;
         for (const auto& mesh : scene->meshes) {
+          if (!IsMeshReady(mesh)) {
+            continue;
+          }
           glm::mat4 mat_world_view_projection =
               shadow_view_projection * mesh.mat_world;
           RenderAPI::CmdPushConstants(
@@ -29,7 +29,9 @@ struct CascadeShadowsPass {
   RenderAPI::ImageView depth_array_view;
   std::vector<RenderAPI::ImageView> cascade_views;
 
-  static CascadeShadowsPass Create(RenderAPI::Device device);
+  static CascadeShadowsPass Create(
+      RenderAPI::Device device,
+      RenderAPI::PipelineCache pipeline_cache = RenderAPI::kInvalidHandle);
   static void Destroy(RenderAPI::Device device, CascadeShadowsPass& shadow);
   static std::vector<RenderGraphResource> AddPass(CascadeShadowsPass* shadow,
                                                   RenderAPI::Device device,
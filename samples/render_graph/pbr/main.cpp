@@ -38,13 +38,19 @@ struct LightDataGPU {
   alignas(16) glm::vec3 uCameraPosition;
   alignas(16) glm::vec3 uLightDirection;
 };
+
+// Pipelines compiled by previous runs, reloaded at startup.
+constexpr char kPipelineCacheFile[] = "pipeline_cache.bin";
 }  // namespace
 
 void CreateVkSurfance(RenderAPI::Instance instance, GLFWwindow* window);
 GLFWwindow* InitWindow();
 void Shutdown(GLFWwindow* window);
 
-void CreateMaterials(RenderAPI::Device device, MaterialCache* cache) {
+void CreateMaterials(RenderAPI::Device device,
+                     RenderAPI::PipelineCache pipeline_cache,
+                     RenderUtils::UniformRing* objects_ring,
+                     MaterialCache* cache) {
   // Default data.
   MetallicRoughnessMaterialGpuData default_material;
   default_material.uBaseColor =
@@ -56,6 +62,7 @@ void CreateMaterials(RenderAPI::Device device, MaterialCache* cache) {
   auto vert = util::ReadFile("samples/render_graph/pbr/data/pbr.vert.spv");
   auto frag = util::ReadFile("samples/render_graph/pbr/data/pbr.frag.spv");
   Material::Builder builder(device);
+  builder.PipelineCache(pipeline_cache);
   builder.VertexCode(reinterpret_cast<const uint32_t*>(vert.data()),
                      vert.size());
   builder.FragmentCode(reinterpret_cast<const uint32_t*>(frag.data()),
@@ -83,8 +90,8 @@ void CreateMaterials(RenderAPI::Device device, MaterialCache* cache) {
           RenderAPI::SamplerAddressMode::kClampToEdge, 0.0f, 9.0f, true,
           RenderAPI::CompareOp::kLessOrEqual));
   // Transform data.
-  builder.Uniform(0, 0, RenderAPI::ShaderStageFlagBits::kVertexBit,
-                  sizeof(ObjectsData));
+  builder.DynamicUniform(0, 0, RenderAPI::ShaderStageFlagBits::kVertexBit,
+                         sizeof(ObjectsData), objects_ring);
   // Material data.
   builder.Texture(1, 0, RenderAPI::ShaderStageFlagBits::kFragmentBit);
   builder.Texture(1, 1, RenderAPI::ShaderStageFlagBits::kFragmentBit);
@@ -151,8 +158,8 @@ void CreateMaterials(RenderAPI::Device device, MaterialCache* cache) {
           RenderAPI::SamplerAddressMode::kClampToEdge, 0.0f, 9.0f, true,
           RenderAPI::CompareOp::kLessOrEqual));
   // Transform data.
-  builder.Uniform(0, 0, RenderAPI::ShaderStageFlagBits::kVertexBit,
-                  sizeof(ObjectsData));
+  builder.DynamicUniform(0, 0, RenderAPI::ShaderStageFlagBits::kVertexBit,
+                         sizeof(ObjectsData), objects_ring);
   // Material data.
   builder.Texture(1, 0, RenderAPI::ShaderStageFlagBits::kFragmentBit, nullptr,
                   RenderAPI::DescriptorBindingFlag::kPartiallyBoundEXT);
@@ -221,7 +228,16 @@ void Run() {
   RenderUtils::TextureManager* texture_manager =
       new RenderUtils::TextureManager(device);
 
+  bool pipeline_cache_discarded = false;
+  RenderAPI::PipelineCache pipeline_cache = RenderAPI::LoadPipelineCache(
+      device, kPipelineCacheFile, &pipeline_cache_discarded);
+  if (pipeline_cache_discarded) {
+    std::cout << "Discarding pipeline cache from another device or driver."
+              << std::endl;
+  }
+
   RenderGraph render_graph_(device);
+  render_graph_.SetPipelineCache(pipeline_cache);
   render_graph_.BuildSwapChain(width, height);
 
   RenderAPI::Image cubemap_image;
@@ -229,9 +245,11 @@ void Run() {
   util::LoadTexture("samples/render_graph/pbr/data/cubemap.ktx", device,
                     command_pool, cubemap_image, cubemap_view);
 
-  Renderer* renderer = new Renderer(device);
+  Renderer* renderer = new Renderer(
+      device, render_graph_.GetMaxFramesInFlight(), pipeline_cache);
   MaterialCache* materials = new MaterialCache();
-  CreateMaterials(device, materials);
+  CreateMaterials(device, pipeline_cache, renderer->GetObjectsRing(),
+                  materials);
   renderer->SetPbrMaterial(materials->Get("Metallic Roughness", 0));
   Scene scene;
   /*scene.meshes.emplace_back(CreateSphereMesh(device, command_pool));
@@ -266,7 +284,7 @@ void Run() {
   scene.SetIndirectLight(irradiance_view, prefilter_view, brdf_view);
   scene.SetSkybox(cubemap_view);
 
-  TonemapPass tonemap = CreateTonemapPass(device);
+  TonemapPass tonemap = CreateTonemapPass(device, pipeline_cache);
 
   CameraController camera;
   camera.position.z = -10.0f;
@@ -276,6 +294,7 @@ void Run() {
   float rotation = 0.0f;
 
   View* view = renderer->CreateView();
+  uint64_t reported_high_water = 0;
   while (!glfwWindowShouldClose(window)) {
     glfwPollEvents();
 
@@ -306,6 +325,18 @@ void Run() {
     render_graph_.MoveSubresource(output,
                                   render_graph_.GetBackbufferResource());
     render_graph_.Render();
+
+    // Report the transient memory whenever the graph's footprint changes.
+    const RenderGraphMemoryStats& memory =
+        render_graph_.GetTransientMemoryStats();
+    if (memory.high_water_bytes != reported_high_water) {
+      reported_high_water = memory.high_water_bytes;
+      std::cout << "Transient memory: "
+                << memory.high_water_bytes / (1024 * 1024) << "MB aliased, "
+                << memory.naive_bytes / (1024 * 1024) << "MB dedicated, "
+                << memory.heap_bytes / (1024 * 1024) << "MB in heaps."
+                << std::endl;
+    }
   }
 
   render_graph_.Destroy();
@@ -325,6 +356,10 @@ void Run() {
   RenderAPI::DestroyImageView(device, brdf_view);
   RenderAPI::DestroyImage(brdf_image);
   RenderAPI::DestroyCommandPool(command_pool);
+  if (!RenderAPI::SavePipelineCache(pipeline_cache, kPipelineCacheFile)) {
+    std::cout << "Failed to save the pipeline cache." << std::endl;
+  }
+  RenderAPI::DestroyPipelineCache(pipeline_cache);
   RenderAPI::DestroyDevice(device);
   RenderAPI::Destroy(instance);
   Shutdown(window);
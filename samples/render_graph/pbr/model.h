@@ -51,8 +51,17 @@ struct Primitive {
 struct Mesh {
   std::vector<Primitive> primitives;
   glm::mat4 mat_world = glm::mat4(1.0f);
+
+  // Meshes uploaded asynchronously are skipped until the upload completes.
+  RenderAPI::UploadQueue uploads = RenderAPI::kInvalidHandle;
+  RenderAPI::UploadToken upload = 0;
 };
 
+inline bool IsMeshReady(const Mesh& mesh) {
+  return mesh.uploads == RenderAPI::kInvalidHandle ||
+         RenderAPI::IsUploadComplete(mesh.uploads, mesh.upload);
+}
+
 inline void DestroyTexture(RenderAPI::Device device, Texture& texture) {
   if (texture.sampler != RenderAPI::kInvalidHandle) {
     RenderAPI::DestroySampler(device, texture.sampler);
@@ -69,6 +78,9 @@ inline void DestroyTexture(RenderAPI::Device device, Texture& texture) {
 }
 
 inline void DestroyMesh(RenderAPI::Device device, Mesh& mesh) {
+  if (mesh.uploads != RenderAPI::kInvalidHandle) {
+    RenderAPI::WaitForUpload(mesh.uploads, mesh.upload);
+  }
   for (auto& primitive : mesh.primitives) {
     if (primitive.vertex_buffer != RenderAPI::kInvalidHandle) {
       RenderAPI::DestroyBuffer(primitive.vertex_buffer);
@@ -136,8 +136,12 @@ void CreateCubemap(RenderAPI::Device device,
 }
 }  // namespace
 
-Renderer::Renderer(RenderAPI::Device device) : device_(device) {
+Renderer::Renderer(RenderAPI::Device device, uint32_t frames_in_flight,
+                   RenderAPI::PipelineCache pipeline_cache)
+    : device_(device) {
   command_pool_ = RenderAPI::CreateCommandPool(device_);
+  objects_ring_ = RenderUtils::UniformRing::Create(
+      device_, kMaxInstances * sizeof(ObjectsData), frames_in_flight);
 
   CreateCubemap(device_, command_pool_, cubemap_vertex_buffer_,
                 cubemap_index_buffer_);
@@ -147,6 +151,7 @@ Renderer::Renderer(RenderAPI::Device device) : device_(device) {
   auto frag = ReadFile("samples/render_graph/pbr/data/cubemap.frag.spv");
 
   Material::Builder skybox_builder(device);
+  skybox_builder.PipelineCache(pipeline_cache);
   skybox_builder.VertexCode(reinterpret_cast<const uint32_t*>(vert.data()),
                             vert.size());
   skybox_builder.FragmentCode(reinterpret_cast<const uint32_t*>(frag.data()),
@@ -171,12 +176,13 @@ Renderer::Renderer(RenderAPI::Device device) : device_(device) {
   skybox_material_ = skybox_builder.Build();
 
   // Create the shadow pass.
-  shadow_pass_ = CascadeShadowsPass::Create(device);
+  shadow_pass_ = CascadeShadowsPass::Create(device, pipeline_cache);
 }
 
 Renderer::~Renderer() {
   Material::Destroy(skybox_material_);
   CascadeShadowsPass::Destroy(device_, shadow_pass_);
+  RenderUtils::UniformRing::Destroy(objects_ring_);
 
   if (cubemap_vertex_buffer_ != RenderAPI::kInvalidHandle) {
     RenderAPI::DestroyBuffer(cubemap_vertex_buffer_);
@@ -195,6 +201,7 @@ Renderer::~Renderer() {
 
 RenderGraphResource Renderer::Render(RenderGraph& render_graph, View* view,
                                      Scene* scene) {
+  objects_ring_->NextFrame();
   RenderAPI::ImageView shadow_texture = shadow_pass_.depth_array_view;
   std::vector<RenderGraphResource> render_graph_resources =
       CascadeShadowsPass::AddPass(&shadow_pass_, device_, render_graph, view,
@@ -265,7 +272,13 @@ void Renderer::Render(RenderContext* context, View* view, Scene& scene) {
   ObjectsData objects_data;
   objects_data.uMatView = camera_view;
   size_t instance_id = 0;
+  // The light data is per view, it is only bound again when a material has a
+  // different layout.
+  RenderAPI::PipelineLayout bound_layout = RenderAPI::kInvalidHandle;
   for (const auto& mesh : scene.meshes) {
+    if (!IsMeshReady(mesh)) {
+      continue;
+    }
     // Update the uniform data for the mesh.
     objects_data.uMatWorld = mesh.mat_world;
     objects_data.uMatWorldViewProjection =
@@ -280,14 +293,18 @@ void Renderer::Render(RenderContext* context, View* view, Scene& scene) {
       RenderAPI::CmdBindPipeline(cmd, material->GetPipeline(context->pass));
       RenderAPI::CmdSetScissor(cmd, 0, 1, &scissor);
       RenderAPI::CmdSetViewport(cmd, 0, 1, &view->viewport);
-      RenderAPI::CmdBindDescriptorSets(cmd, 0, material->GetPipelineLayout(), 2,
-                                       1, view->light_params->DescriptorSet());
-
-      instance->SetParam(0, 0, objects_data);
-      instance->Commit();
-
-      RenderAPI::CmdBindDescriptorSets(cmd, 0, material->GetPipelineLayout(), 0,
-                                       1, instance->DescriptorSet(0));
+      if (material->GetPipelineLayout() != bound_layout) {
+        bound_layout = material->GetPipelineLayout();
+        RenderAPI::CmdBindDescriptorSets(cmd, 0, bound_layout, 2, 1,
+                                         view->light_params->DescriptorSet());
+      }
+
+      instance->SetDynamicParam(0, 0, objects_data);
+
+      RenderAPI::CmdBindDescriptorSets(
+          cmd, 0, material->GetPipelineLayout(), 0, 1,
+          instance->DescriptorSet(0), instance->DynamicOffsetsCount(0),
+          instance->DynamicOffsets(0));
       RenderAPI::CmdBindDescriptorSets(cmd, 0, material->GetPipelineLayout(), 1,
                                        1, instance->DescriptorSet(1));
 
@@ -353,4 +370,6 @@ void Renderer::DestroyView(View** view) {
   *view = nullptr;
 }
 
-void Renderer::SetPbrMaterial(Material* material) { pbr_material_ = material; }
\ No newline at end of file
+void Renderer::SetPbrMaterial(Material* material) { pbr_material_ = material; }
+
+RenderUtils::UniformRing* Renderer::GetObjectsRing() { return objects_ring_; }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <RenderAPI/RenderAPI.h>
+#include <RenderUtils/UniformRing.h>
 #include <glm/glm.hpp>
 #include "cascade_shadow_pass.h"
 #include "render_graph/render_graph.h"
@@ -9,7 +10,10 @@
 
 class Renderer {
  public:
-  Renderer(RenderAPI::Device device);
+  // frames_in_flight sizes the per frame buffers, see
+  // RenderGraph::GetMaxFramesInFlight.
+  Renderer(RenderAPI::Device device, uint32_t frames_in_flight,
+           RenderAPI::PipelineCache pipeline_cache = RenderAPI::kInvalidHandle);
   ~Renderer();
 
   RenderGraphResource Render(RenderGraph& render_graph, View* view,
@@ -19,6 +23,8 @@ class Renderer {
   void DestroyView(View** view);
 
   void SetPbrMaterial(Material* material);
+  // Ring the PBR materials' per-object uniforms are written into.
+  RenderUtils::UniformRing* GetObjectsRing();
 
  private:
   RenderAPI::Device device_;
@@ -27,6 +33,7 @@ class Renderer {
 
   // PBR Pipeline.
   Material* pbr_material_;
+  RenderUtils::UniformRing* objects_ring_ = nullptr;
 
   // Skybox Material.
   Material* skybox_material_;
@@ -96,6 +96,9 @@ RenderGraphResource ShadowPass::AddPass(
 
         size_t instance_id = 0;
         for (const auto& mesh : scene->meshes) {
+          if (!IsMeshReady(mesh)) {
+            continue;
+          }
           for (const auto& primitive : mesh.primitives) {
             RenderAPI::CmdBindVertexBuffers(cmd, 0, 1,
                                             &primitive.vertex_buffer);
@@ -1,8 +1,10 @@
 #include "tonemap_pass.h"
 
+#include <RenderUtils/SamplerCache.h>
 #include "samples/common/util.h"
 
-TonemapPass CreateTonemapPass(RenderAPI::Device device) {
+TonemapPass CreateTonemapPass(RenderAPI::Device device,
+                              RenderAPI::PipelineCache pipeline_cache) {
   TonemapPass tonemap;
 
   // Create the render pass.
@@ -17,7 +19,8 @@ TonemapPass CreateTonemapPass(RenderAPI::Device device) {
   RenderAPI::SamplerCreateInfo sampler_info;
   sampler_info.mag_filter = RenderAPI::SamplerFilter::kLinear;
   sampler_info.min_filter = RenderAPI::SamplerFilter::kLinear;
-  tonemap.sampler = RenderAPI::CreateSampler(device, sampler_info);
+  tonemap.sampler =
+      RenderUtils::SamplerCache::Get().Acquire(device, sampler_info);
 
   // Create the descriptor layout.
   RenderAPI::DescriptorSetLayoutCreateInfo descriptor_layout_info;
@@ -53,8 +56,8 @@ TonemapPass CreateTonemapPass(RenderAPI::Device device) {
       RenderAPI::DynamicState::kViewport);
   info.states.dynamic_states.states.push_back(
       RenderAPI::DynamicState::kScissor);
-  tonemap.pipeline =
-      RenderAPI::CreateGraphicsPipeline(device, tonemap.pass, info);
+  tonemap.pipeline = RenderAPI::CreateGraphicsPipeline(device, tonemap.pass,
+                                                       info, pipeline_cache);
 
   // Create the descriptor set pool.
   RenderAPI::CreateDescriptorSetPoolCreateInfo pool_info = {
@@ -76,7 +79,7 @@ void DestroyTonemapPass(RenderAPI::Device device, TonemapPass& tonemap) {
   RenderAPI::DestroyRenderPass(tonemap.pass);
   RenderAPI::DestroyDescriptorSetPool(tonemap.descriptor_set_pool);
   RenderAPI::DestroyDescriptorSetLayout(tonemap.descriptor_layout);
-  RenderAPI::DestroySampler(device, tonemap.sampler);
+  RenderUtils::SamplerCache::Get().Release(tonemap.sampler);
 }
 
 RenderGraphResource AddTonemapPass(RenderAPI::Device device,
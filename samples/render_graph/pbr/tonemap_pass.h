@@ -19,7 +19,9 @@ struct TonemapPass {
   RenderAPI::Sampler sampler;
 };
 
-TonemapPass CreateTonemapPass(RenderAPI::Device device);
+TonemapPass CreateTonemapPass(
+    RenderAPI::Device device,
+    RenderAPI::PipelineCache pipeline_cache = RenderAPI::kInvalidHandle);
 void DestroyTonemapPass(RenderAPI::Device device, TonemapPass& tonemap);
 RenderGraphResource AddTonemapPass(RenderAPI::Device device,
                                    RenderGraph& render_graph,
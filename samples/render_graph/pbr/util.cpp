@@ -288,7 +288,7 @@ std::vector<Vertex> VerticesFromGltf(const tinygltf::Model& gltf,
 }
 
 RenderAPI::Buffer IndexBufferFromGltf(RenderAPI::Device device,
-                                      RenderAPI::CommandPool command_pool,
+                                      RenderAPI::UploadQueue uploads,
                                       const tinygltf::Model& gltf,
                                       const tinygltf::Primitive& primitive,
                                       uint32_t& num_primitives) {
@@ -338,8 +338,8 @@ RenderAPI::Buffer IndexBufferFromGltf(RenderAPI::Device device,
   RenderAPI::Buffer index_buffer = RenderAPI::CreateBuffer(
       device, RenderAPI::BufferUsageFlagBits::kIndexBuffer,
       sizeof(uint32_t) * num_primitives, RenderAPI::MemoryUsage::kGpu);
-  RenderAPI::StageCopyDataToBuffer(command_pool, index_buffer, copy_indices,
-                                   sizeof(uint32_t) * num_primitives);
+  RenderAPI::UploadToBuffer(uploads, index_buffer, copy_indices,
+                            sizeof(uint32_t) * num_primitives);
 
   if (indices) {
     delete[] indices;
@@ -414,6 +414,9 @@ bool MeshFromGLTF(RenderAPI::Device device, RenderAPI::CommandPool command_pool,
     std::cout << "Loaded glTF: " << filename << std::endl;
   }
 
+  // Textures and buffers share the texture manager's upload queue so a single
+  // token covers the whole mesh.
+  RenderAPI::UploadQueue uploads = texture_manager->GetUploadQueue();
   std::vector<RenderAPI::ImageView> images;
   images.reserve(gltf.images.size());
   for (const auto& it : gltf.images) {
@@ -527,13 +530,13 @@ bool MeshFromGLTF(RenderAPI::Device device, RenderAPI::CommandPool command_pool,
       Primitive primitive;
       primitive.material = materials[gltf_primitive.material];
       primitive.index_buffer = IndexBufferFromGltf(
-          device, command_pool, gltf, gltf_primitive, primitive.num_primitives);
+          device, uploads, gltf, gltf_primitive, primitive.num_primitives);
       primitive.vertex_buffer = RenderAPI::CreateBuffer(
           device, RenderAPI::BufferUsageFlagBits::kVertexBuffer,
           sizeof(Vertex) * vertices.size(), RenderAPI::MemoryUsage::kGpu);
-      RenderAPI::StageCopyDataToBuffer(command_pool, primitive.vertex_buffer,
-                                       vertices.data(),
-                                       sizeof(Vertex) * vertices.size());
+      RenderAPI::UploadToBuffer(uploads, primitive.vertex_buffer,
+                                vertices.data(),
+                                sizeof(Vertex) * vertices.size());
 
       mesh.primitives.push_back(std::move(primitive));
     }
@@ -558,5 +561,9 @@ bool MeshFromGLTF(RenderAPI::Device device, RenderAPI::CommandPool command_pool,
   }
   mesh.mat_world = mat;
 
+  // Don't wait on the uploads, the mesh is drawn once they complete.
+  mesh.uploads = uploads;
+  mesh.upload = texture_manager->Flush();
+
   return true;
 }
\ No newline at end of file